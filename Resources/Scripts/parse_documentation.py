@@ -261,6 +261,47 @@ def markdownToXml(root, md):
         outlet.set("tooltip", tip.strip())
         iolets.append(outlet)
 
+# Write the documentation as an indexed file, so plugdata can decode objects one at a time
+# Layout (all integers are little endian uint32, offsets are from the start of the file):
+#   magic "PDDX", version, number of objects
+#   offset table sorted by UTF-8 name: name offset, name length, entry offset, entry length
+#   names, followed by every object encoded in JUCE's ValueTree binary format
+def writeIndexedDocumentation(root):
+  objects = {}
+  for child in root:
+    name = child.get("name").strip().encode('utf-8')
+    # Keep the first object if a name is documented twice
+    if len(name) and name not in objects:
+      objects[name] = child
+
+  names = sorted(objects.keys())
+
+  headerSize = 12
+  tableSize = len(names) * 16
+
+  nameData = bytearray()
+  entryData = bytearray()
+  table = bytearray()
+
+  namesStart = headerSize + tableSize
+  entriesStart = namesStart + sum(len(name) for name in names)
+
+  for name in names:
+    entry = bytearray()
+    writeToStream(entry, objects[name])
+
+    for value in [namesStart + len(nameData), len(name), entriesStart + len(entryData), len(entry)]:
+      table += value.to_bytes(4, byteorder='little')
+
+    nameData += name
+    entryData += entry
+
+  stream = bytearray(b"PDDX")
+  stream += (1).to_bytes(4, byteorder='little')
+  stream += len(names).to_bytes(4, byteorder='little')
+  stream += table + nameData + entryData
+  return stream
+
 # Iterate over markdown files in search dirs
 def parseFilesInDir(dir, generateXml, generateWebsite):
   directory = os.fsencode(dir)
@@ -280,9 +321,7 @@ def parseFilesInDir(dir, generateXml, generateWebsite):
     tree = ET.ElementTree(root)
     tree.write("../Documentation/Documentation.xml")
 
-  # Convert xml to JUCE ValueTree binary format
-  stream = bytearray()
-  writeToStream(stream, root)
+  stream = writeIndexedDocumentation(root)
 
   if generateWebsite:
     for child in root:
@@ -13,6 +13,7 @@
 #include "Object.h"
 #include "Connection.h"
 #include "PluginProcessor.h"
+#include "Utility/PatchSearchIndex.h"
 #include "PluginEditor.h"
 #include "LookAndFeel.h"
 #include "Components/SuggestionComponent.h"
@@ -295,40 +296,26 @@ void Canvas::paint(Graphics& g)
     auto scale = ::getValue<float>(zoomScale);
 
     if (!getValue<bool>(locked)) {
+        // Fill the clip region with a pre-rendered tile of the dot grid, instead of filling every dot separately
+        auto const pixelScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        auto const& tile = getGridTile(scale, pixelScale);
+        auto const tileScale = tile.getWidth() / static_cast<float>(objectGrid.gridSize * 4);
+        auto const halfGridSize = objectGrid.gridSize * 0.5f;
 
-        auto startX = (canvasOrigin.x % objectGrid.gridSize);
-        startX += ((clipBounds.getX() / objectGrid.gridSize) * objectGrid.gridSize);
+        g.setFillType(FillType(tile, AffineTransform::scale(1.0f / tileScale).translated(canvasOrigin.x - halfGridSize, canvasOrigin.y - halfGridSize)));
+        g.fillRect(clipBounds);
 
-        auto startY = (canvasOrigin.y % objectGrid.gridSize);
-        startY += ((clipBounds.getY() / objectGrid.gridSize) * objectGrid.gridSize);
+        // Don't draw dots over origin or border line
+        if (showBorder || showOrigin) {
+            auto const dotWidth = scale < 1.0f ? 1.0f / jmap(scale, 0.3f, 1.0f, 0.4f, 1.0f) : 1.0f;
+            auto const originX = static_cast<float>(canvasOrigin.x);
+            auto const originY = static_cast<float>(canvasOrigin.y);
+            auto const right = showOrigin ? static_cast<float>(clipBounds.getRight()) : patchWidthCanvas + dotWidth;
+            auto const bottom = showOrigin ? static_cast<float>(clipBounds.getBottom()) : patchHeightCanvas + dotWidth;
 
-        g.setColour(findColour(PlugDataColour::canvasDotsColourId));
-
-        for (int x = startX; x < clipBounds.getRight(); x += objectGrid.gridSize) {
-            // calculate the x here, once per iteration, as it won't change for y
-            auto const gridSpacing = objectGrid.gridSize * 4;
-            auto const xGridSpacing = (x - canvasOrigin.x) % gridSpacing == 0;
-
-            for (int y = startY; y < clipBounds.getBottom(); y += objectGrid.gridSize) {
-
-                // Don't draw over origin or border line
-                if (showBorder || showOrigin) {
-                    if ((x == canvasOrigin.x && y >= canvasOrigin.y && (showOrigin || (y <= patchHeightCanvas))) || (y == canvasOrigin.y && x >= canvasOrigin.x && (showOrigin || (x <= patchWidthCanvas))))
-                        continue;
-                }
-                auto dotWidth = 1.0f;
-                if (scale < 1.0f) {
-                    if (((y - canvasOrigin.y) % gridSpacing == 0) || xGridSpacing) {
-                        dotWidth = 1.0f / jmap(scale, 0.3f, 1.0f, 0.4f, 1.0f);
-                    } else {
-                        // TIM: draw the dot's differently for some grid sizes, or not at all?
-                        if (objectGrid.gridSize == 5)
-                            continue;
-                    }
-                }
-                auto halfDotWidth = dotWidth * 0.5f;
-                g.fillRect(static_cast<float>(x) - halfDotWidth, static_cast<float>(y) - halfDotWidth, dotWidth, dotWidth);
-            }
+            g.setColour(findColour(PlugDataColour::canvasBackgroundColourId));
+            g.fillRect(Rectangle<float>::leftTopRightBottom(originX - dotWidth, originY - dotWidth, originX + dotWidth, bottom));
+            g.fillRect(Rectangle<float>::leftTopRightBottom(originX - dotWidth, originY - dotWidth, right, originY + dotWidth));
         }
     }
 
@@ -385,6 +372,47 @@ void Canvas::paint(Graphics& g)
     }
 }
 
+Image const& Canvas::getGridTile(float zoom, float pixelScale)
+{
+    auto const gridSize = objectGrid.gridSize;
+    auto const tileSize = gridSize * 4;
+    auto const tilePixels = jmax(1, roundToInt(tileSize * pixelScale));
+    auto const zoomBucket = roundToInt(jmin(zoom, 1.0f) * 20.0f);
+    auto const dotColour = findColour(PlugDataColour::canvasDotsColourId);
+
+    if (gridTile.isValid() && gridTile.getWidth() == tilePixels && gridTileSize == gridSize && gridTileZoomBucket == zoomBucket && gridTileColour == dotColour)
+        return gridTile;
+
+    gridTileSize = gridSize;
+    gridTileZoomBucket = zoomBucket;
+    gridTileColour = dotColour;
+
+    gridTile = Image(Image::ARGB, tilePixels, tilePixels, true);
+    Graphics g(gridTile);
+    g.addTransform(AffineTransform::scale(tilePixels / static_cast<float>(tileSize)));
+    g.setColour(dotColour);
+
+    // The tile spans 4x4 grid cells, where the first row and column are the major grid lines
+    // Dots are offset by half a cell, so they don't get cut off at the edges of the tile
+    auto const bucketZoom = zoomBucket / 20.0f;
+    for (int x = 0; x < 4; x++) {
+        for (int y = 0; y < 4; y++) {
+            auto dotWidth = 1.0f;
+            if (bucketZoom < 1.0f) {
+                if (x == 0 || y == 0) {
+                    dotWidth = 1.0f / jmap(bucketZoom, 0.3f, 1.0f, 0.4f, 1.0f);
+                } else if (gridSize == 5) {
+                    continue;
+                }
+            }
+            auto const centre = Point<float>((x + 0.5f) * gridSize, (y + 0.5f) * gridSize);
+            g.fillRect(Rectangle<float>(dotWidth, dotWidth).withCentre(centre));
+        }
+    }
+
+    return gridTile;
+}
+
 TabComponent* Canvas::getTabbar()
 {
     for (auto* split : editor->splitView.splits) {
@@ -580,8 +608,13 @@ void Canvas::performSynchronise()
 
     editor->updateCommandStatus();
     repaint();
-    
-    needsSearchUpdate = true;
+
+    // Update the search index with the changes in this patch level
+    // This also picks up moved objects, so the search panel doesn't need to read this level again
+    if (patch.getPointer())
+        pd->searchIndex->updatePatch(patch.getUncheckedPointer());
+
+    needsSearchUpdate = false;
 
     pd->updateObjectImplementations();
 }
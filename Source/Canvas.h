@@ -216,8 +216,16 @@ public:
     inline static constexpr int infiniteCanvasSize = 128000;
 
 private:
+    Image const& getGridTile(float zoom, float pixelScale);
+
     LassoComponent<WeakReference<Component>> lasso;
 
+    // Pre-rendered tile of the dot grid, re-rendered when grid size, zoom or theme changes
+    Image gridTile;
+    int gridTileSize = 0;
+    int gridTileZoomBucket = 0;
+    Colour gridTileColour;
+
     RateReducer canvasRateReducer = RateReducer(90);
 
     // Properties that can be shown in the inspector by right-clicking on canvas
@@ -4,6 +4,8 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
+#include "Utility/StartupTrace.h"
+
 extern "C" {
 EXTERN char* pd_version;
 }
@@ -26,7 +28,7 @@ public:
         credits.setColour(TextEditor::backgroundColourId, Colours::transparentBlack);
         credits.setReadOnly(true);
         credits.setMultiLine(true);
-        credits.setText(creditsText);
+        credits.setText(creditsText + "\n\n\nStartup timeline:\n" + StartupTrace::getInstance()->getSummary());
         credits.setFont(Font(15));
         credits.setLineSpacing(1.1f);
         addAndMakeVisible(credits);
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "Utility/DekenCatalog.h"
+
 struct Spinner : public Component
     , public Timer {
 
@@ -32,33 +34,6 @@ struct Spinner : public Component
     }
 };
 
-// Struct with info about the deken package
-struct PackageInfo {
-    PackageInfo(String name, String author, String timestamp, String url, String description, String version, StringArray objects)
-    {
-        this->name = name;
-        this->author = author;
-        this->timestamp = timestamp;
-        this->url = url;
-        this->description = description;
-        this->version = version;
-        this->objects = objects;
-        packageId = Base64::toBase64(name + "_" + version + "_" + timestamp + "_" + author);
-    }
-
-    // fast compare by ID
-    friend bool operator==(PackageInfo const& lhs, PackageInfo const& rhs)
-    {
-        return lhs.packageId == rhs.packageId;
-    }
-
-    String name, author, timestamp, url, description, version, packageId;
-    StringArray objects;
-};
-
-// Array with package info to store the result of a search action in
-using PackageList = Array<PackageInfo>;
-
 struct PackageSorter {
     static void sort(ValueTree& packageState)
     {
@@ -214,11 +189,21 @@ public:
 #ifndef _MSC_VER
         signal(SIGPIPE, SIG_IGN);
 #endif
-        allPackages = getAvailablePackages();
+        auto newCatalog = getAvailablePackages();
+        {
+            ScopedLock lock(catalogLock);
+            catalog = newCatalog;
+        }
         sendActionMessage("");
     }
 
-    PackageList getAvailablePackages()
+    std::shared_ptr<DekenCatalog const> getCatalog()
+    {
+        ScopedLock lock(catalogLock);
+        return catalog;
+    }
+
+    std::shared_ptr<DekenCatalog const> getAvailablePackages()
     {
 
         // plugdata's deken servers, hosted on GitHub
@@ -228,42 +213,17 @@ public:
         auto triplet = os + "-" + machine + "-" + floatsize;
         auto repoForArchitecture = "https://raw.githubusercontent.com/plugdata-team/plugdata-deken/main/bin/" + triplet + ".bin";
 
-        webstream = std::make_unique<WebInputStream>(URL(repoForArchitecture), false);
-        webstream->connect(nullptr);
-
-        if (webstream->isError()) {
-            sendActionMessage("Failed to connect to server");
-            return {};
-        }
-
+        // The listing is cached, usually the server only has to tell us that it didn't change
         MemoryBlock block;
-        webstream->readIntoMemoryBlock(block);
+        auto result = DekenCatalog::fetch(URL(repoForArchitecture), catalogCache, block, webstream);
 
-        // Parse tree that was downloaded
-        auto tree = ValueTree::readFromData(block.getData(), block.getSize());
+        if (result.failed()) {
+            sendActionMessage(result.getErrorMessage());
+            return std::make_shared<DekenCatalog const>();
+        }
 
         PackageList packages;
 
-        for (auto package : tree) {
-            auto name = package.getProperty("Name").toString();
-
-            for (auto version : package) {
-                auto author = version.getProperty("Author").toString();
-                auto timestamp = version.getProperty("Timestamp").toString();
-                auto url = version.getProperty("URL").toString();
-                auto description = version.getProperty("Description").toString();
-                auto versionNumber = version.getProperty("Version").toString();
-
-                StringArray objects;
-                for (auto object : version.getChildWithName("Objects")) {
-                    objects.add(object.getProperty("Name").toString());
-                }
-
-                packages.add(PackageInfo(name, author, timestamp, url, description, versionNumber, objects));
-                break;
-            }
-        }
-
 #if JUCE_MAC
         packages.add(PackageInfo("plugdata-ofelia",
             "cuinjune and timothyschoen",
@@ -280,7 +240,7 @@ public:
             "v4.0.0-test4", { "ofelia" }));
 #endif
 
-        return packages;
+        return std::make_shared<DekenCatalog const>(block, packages);
     }
 
     // When a property in our pkginfo changes, save it immediately
@@ -351,13 +311,18 @@ public:
         return nullptr;
     }
 
-    PackageList allPackages;
+    // Replaced as a whole when the listing was fetched, so it can be searched while it's being updated
+    CriticalSection catalogLock;
+    std::shared_ptr<DekenCatalog const> catalog = std::make_shared<DekenCatalog const>();
 
     static inline File const filesystem = ProjectInfo::appDataDir.getChildFile("Externals");
 
     // Package info file
     File pkgInfo = filesystem.getChildFile(".pkg_info");
 
+    // Cached package listing, revalidated with the server every time we update
+    File catalogCache = filesystem.getChildFile(".deken_catalog");
+
     // Package state tree, keeps track of which packages are installed and saves it to pkgInfo
     ValueTree packageState = ValueTree("pkg_info");
 
@@ -621,47 +586,12 @@ public:
             return;
         }
 
-        PackageList allPackages = packageManager->allPackages;
+        auto catalog = packageManager->getCatalog();
 
         if (isSearching && !query.isEmpty()) {
-            // First check for name match
-            for (auto const& result : allPackages) {
-                if (result.name.contains(query)) {
-                    newResult.addIfNotAlreadyThere(result);
-                }
-            }
-
-            // Then check for description match
-            for (auto const& result : allPackages) {
-                if (result.description.contains(query)) {
-                    newResult.addIfNotAlreadyThere(result);
-                }
-            }
-
-            // Then check for object match
-            for (auto const& result : allPackages) {
-                if (result.objects.contains(query)) {
-                    newResult.addIfNotAlreadyThere(result);
-                }
-            }
-
-            // Then check for author match
-            for (auto const& result : allPackages) {
-                if (result.author.contains(query)) {
-                    newResult.addIfNotAlreadyThere(result);
-                }
-            }
-
-            // Then check for object close match
-            for (auto const& result : allPackages) {
-                for (auto const& obj : result.objects) {
-                    if (obj.contains(query)) {
-                        newResult.addIfNotAlreadyThere(result);
-                    }
-                }
-            }
+            newResult = catalog->search(query);
         } else if (!isSearching) {
-            newResult = allPackages;
+            newResult = catalog->getPackages();
         }
 
         // Downloads are already always visible, so filter them out here
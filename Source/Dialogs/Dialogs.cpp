@@ -17,6 +17,7 @@
 #include "LookAndFeel.h"
 #include "PluginEditor.h"
 #include "PluginProcessor.h"
+#include "Utility/SignalProbes.h"
 
 #include "Components/ArrowPopupMenu.h"
 #include "Components/Buttons.h"
@@ -517,6 +518,52 @@ void Dialogs::showCanvasRightClickMenu(Canvas* cnv, Component* originalComponent
     });
     addCommandItem(popupMenu, CommandIDs::ConnectionPathfind);
 
+    // Pin probes on the selected signal connections, either all channels or a single channel of a multichannel signal
+    PopupMenu probeMenu;
+    auto selectedConnections = cnv->getSelectionOfType<Connection>();
+    auto* probeManager = editor->pd->signalProbes.get();
+    auto addProbes = [editor, probeManager](Array<Component::SafePointer<Connection>> const& connections, int channel) {
+        for (auto& connection : connections) {
+            if (!connection || !connection->outobj)
+                continue;
+
+            auto numChannels = channel < 0 ? std::max(connection->numSignalChannels, 1) : 1;
+            for (int ch = 0; ch < numChannels; ch++) {
+                auto probeChannel = channel < 0 ? ch : channel;
+                auto name = connection->outobj->gui->getType() + " ~" + String(connection->outIdx) + " ch " + String(probeChannel + 1);
+                if (!probeManager->addProbe(connection->getPointer(), probeChannel, name)) {
+                    editor->pd->logWarning("Signal probe limit of " + String(SignalProbeManager::maxProbedChannels) + " channels reached");
+                    return;
+                }
+            }
+        }
+    };
+
+    Array<Component::SafePointer<Connection>> signalConnections;
+    int maxChannels = 0;
+    for (auto* connection : selectedConnections) {
+        if (connection->outlet && connection->outlet->isSignal) {
+            signalConnections.add(connection);
+            maxChannels = std::max(maxChannels, connection->numSignalChannels);
+        }
+    }
+
+    probeMenu.addItem("All channels", !signalConnections.isEmpty(), false, [addProbes, signalConnections]() { addProbes(signalConnections, -1); });
+    if (maxChannels > 1) {
+        probeMenu.addSeparator();
+        for (int ch = 0; ch < maxChannels; ch++) {
+            probeMenu.addItem("Channel " + String(ch + 1), true, false, [addProbes, signalConnections, ch]() { addProbes(signalConnections, ch); });
+        }
+    }
+    probeMenu.addSeparator();
+    probeMenu.addItem("Remove probes", !signalConnections.isEmpty(), false, [probeManager, signalConnections]() {
+        for (auto& connection : signalConnections) {
+            if (connection)
+                probeManager->removeProbesForConnection(connection->getPointer());
+        }
+    });
+    popupMenu.addSubMenu("Signal probe", probeMenu, !signalConnections.isEmpty());
+
     popupMenu.addSeparator();
     addCommandItem(popupMenu, CommandIDs::Encapsulate);
     popupMenu.addSeparator();
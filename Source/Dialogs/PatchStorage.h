@@ -1,11 +1,10 @@
+#include "Utility/ThumbnailCache.h"
 
-class OnlineImage : public Component
-    , public ThreadPoolJob
-    , private AsyncUpdater {
+// Shows a thumbnail of an image on patchstorage, fetched through the shared thumbnail cache
+class OnlineImage : public Component {
 public:
     OnlineImage(bool roundedTop, bool roundedBottom)
-        : ThreadPoolJob("Image download job")
-        , roundTop(roundedTop)
+        : roundTop(roundedTop)
         , roundBottom(roundedBottom)
     {
         spinner.setSize(50, 50);
@@ -14,23 +13,10 @@ public:
         setInterceptsMouseClicks(false, false);
     }
 
-    ~OnlineImage() override
-    {
-        // Stop the thread
-        signalJobShouldExit();
-        imageDownloadPool.removeJob(this, true, -1);
-    }
-
     void setImageURL(const URL& url)
     {
-        downloadedImage = Image();
-
-        // Lock the thread to safely update the image URL
-        ScopedLock const sl(lock);
         imageURL = url;
-        imageDownloadPool.addJob(this, false);
-        spinner.startSpinning();
-        repaint();
+        requestThumbnail();
     }
 
     void paint(Graphics& g) override
@@ -39,7 +25,7 @@ public:
         Path roundedRectanglePath;
         roundedRectanglePath.addRoundedRectangle(0, 0, getWidth(), getHeight(), Corners::largeCornerRadius, Corners::largeCornerRadius, roundTop, roundTop, roundBottom, roundBottom);
 
-        if (!downloadedImage.isValid()) {
+        if (!thumbnail.isValid()) {
             g.setColour(findColour(PlugDataColour::panelForegroundColourId));
             g.fillPath(roundedRectanglePath);
             return;
@@ -50,19 +36,8 @@ public:
         // Set the path as the clip region for the Graphics context
         g.reduceClipRegion(roundedRectanglePath);
 
-        float scaleX = static_cast<float>(getWidth()) / downloadedImage.getWidth();
-        float scaleY = static_cast<float>(getHeight()) / downloadedImage.getHeight();
-        float scale = jmax(scaleX, scaleY);
-
-        // Calculate the translation values to keep the image centered
-        float translateX = (getWidth() - downloadedImage.getWidth() * scale) * 0.5f;
-        float translateY = (getHeight() - downloadedImage.getHeight() * scale) * 0.5f;
-
-        // Apply the transformation to the Graphics context
-        g.addTransform(AffineTransform::translation(translateX, translateY).scaled(scale));
-
-        // Apply the transformation to the Graphics context
-        g.drawImage(downloadedImage, 0, 0, downloadedImage.getWidth(), downloadedImage.getHeight(), 0, 0, downloadedImage.getWidth(), downloadedImage.getHeight());
+        // The thumbnail is already scaled and cropped to our size
+        g.drawImage(thumbnail, getLocalBounds().toFloat());
 
         g.restoreState();
     }
@@ -70,41 +45,58 @@ public:
     void resized() override
     {
         spinner.setCentrePosition(getWidth() / 2, getHeight() / 2);
+
+        // Thumbnails are cached per size
+        requestThumbnail();
     }
 
 private:
-    bool roundTop, roundBottom;
-    URL imageURL;
-    Image downloadedImage;
-    Spinner spinner;
+    void requestThumbnail()
+    {
+        auto scale = Desktop::getInstance().getDisplays().getPrimaryDisplay() ? Desktop::getInstance().getDisplays().getPrimaryDisplay()->scale : 1.0;
+        auto width = roundToInt(getWidth() * scale);
+        auto height = roundToInt(getHeight() * scale);
 
-    CriticalSection lock;
+        if (!imageURL.isWellFormed() || width <= 0 || height <= 0)
+            return;
 
-    JobStatus runJob() override
-    {
-        // Check if there's an image URL to download
-        if (imageURL.isWellFormed()) {
-            MemoryBlock block;
-            // Load the image data from the URL
-            MemoryInputStream memstream(block, false);
+        if (imageURL == requestedURL && width == requestedWidth && height == requestedHeight)
+            return;
 
-            downloadedImage = ImageFileFormat::loadFrom(block.getData(), block.getSize());
+        requestedURL = imageURL;
+        requestedWidth = width;
+        requestedHeight = height;
 
-            // Redraw the component on the message thread
-            triggerAsyncUpdate();
+        // In memory, no need to show the spinner
+        thumbnail = thumbnailCache->getCachedThumbnail(imageURL, width, height);
+        if (thumbnail.isValid()) {
+            spinner.stopSpinning();
+            repaint();
+            return;
         }
 
-        return jobHasFinished;
-    }
-
-    void handleAsyncUpdate() override
-    {
-        // Repaint the component with the downloaded image or the spinner
+        spinner.startSpinning();
         repaint();
-        spinner.stopSpinning();
+
+        thumbnailCache->requestThumbnail(imageURL, width, height, [_this = SafePointer(this), url = imageURL, width, height](Image image) {
+            // Ignore thumbnails for an image or size we don't show anymore
+            if (!_this || _this->requestedURL != url || _this->requestedWidth != width || _this->requestedHeight != height)
+                return;
+
+            _this->thumbnail = image;
+            _this->spinner.stopSpinning();
+            _this->repaint();
+        });
     }
 
-    static inline ThreadPool imageDownloadPool;
+    bool roundTop, roundBottom;
+    URL imageURL;
+    URL requestedURL;
+    int requestedWidth = 0, requestedHeight = 0;
+    Image thumbnail;
+    Spinner spinner;
+
+    SharedResourcePointer<ThumbnailCache> thumbnailCache;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OnlineImage)
 };
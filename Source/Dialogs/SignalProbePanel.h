@@ -0,0 +1,227 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+*/
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "Constants.h"
+#include "LookAndFeel.h"
+#include "Utility/Fonts.h"
+#include "Utility/SignalProbes.h"
+
+// Floating panel that shows all pinned signal probes, with a scope or spectrum view and RMS/peak meters for each
+// All analysis is done by the SignalProbeManager on the message thread, this only draws the results
+class SignalProbePanel : public Component
+    , public SignalProbeManager::Listener {
+
+    class ProbeList : public Component {
+    public:
+        explicit ProbeList(SignalProbePanel& parent)
+            : panel(parent)
+        {
+        }
+
+        void paint(Graphics& g) override
+        {
+            auto& probes = panel.probeManager;
+            for (int i = 0; i < probes.getNumProbes(); i++) {
+                paintProbe(g, *probes.getProbe(i), getRowBounds(i));
+            }
+        }
+
+        void mouseUp(MouseEvent const& e) override
+        {
+            auto& probes = panel.probeManager;
+            for (int i = 0; i < probes.getNumProbes(); i++) {
+                if (getRemoveButtonBounds(getRowBounds(i)).contains(e.getPosition())) {
+                    probes.removeProbe(probes.getProbe(i));
+                    return;
+                }
+            }
+        }
+
+        static Rectangle<int> getRemoveButtonBounds(Rectangle<int> row)
+        {
+            return row.removeFromTop(headerHeight).removeFromRight(headerHeight);
+        }
+
+        Rectangle<int> getRowBounds(int index) const
+        {
+            return { 0, index * rowHeight, getWidth(), rowHeight };
+        }
+
+        void paintProbe(Graphics& g, SignalProbe& probe, Rectangle<int> row)
+        {
+            auto textColour = findColour(PlugDataColour::panelTextColourId);
+            auto signalColour = findColour(PlugDataColour::signalColourId);
+
+            row = row.reduced(6, 3);
+            auto header = row.removeFromTop(headerHeight);
+
+            g.setColour(textColour.withAlpha(0.5f));
+            g.drawText(String::fromUTF8("\xc3\x97"), header.removeFromRight(headerHeight), Justification::centred);
+
+            auto levels = String(Decibels::gainToDecibels(probe.rms, -96.0f), 1) + " / " + String(Decibels::gainToDecibels(probe.peak, -96.0f), 1) + " dB";
+            g.setFont(Fonts::getTabularNumbersFont().withHeight(11.f));
+            g.drawText(levels, header.removeFromRight(90), Justification::centredRight);
+
+            g.setColour(textColour);
+            g.setFont(Fonts::getSemiBoldFont().withHeight(12.f));
+            g.drawText(probe.name, header, Justification::centredLeft, true);
+
+            // Level meter
+            auto meter = row.removeFromBottom(4).toFloat();
+            g.setColour(findColour(PlugDataColour::levelMeterBackgroundColourId));
+            g.fillRoundedRectangle(meter, 2.0f);
+            g.setColour(signalColour.withAlpha(0.5f));
+            g.fillRoundedRectangle(meter.withWidth(meter.getWidth() * jlimit(0.0f, 1.0f, probe.peak)), 2.0f);
+            g.setColour(signalColour);
+            g.fillRoundedRectangle(meter.withWidth(meter.getWidth() * jlimit(0.0f, 1.0f, probe.rms)), 2.0f);
+
+            auto graph = row.reduced(0, 3).toFloat();
+            g.setColour(findColour(PlugDataColour::canvasBackgroundColourId));
+            g.fillRoundedRectangle(graph, Corners::defaultCornerRadius);
+
+            Path path;
+            if (panel.showSpectrum)
+                createSpectrumPath(path, probe, graph);
+            else
+                createScopePath(path, probe, graph);
+
+            g.setColour(signalColour);
+            g.strokePath(path, PathStrokeType(1.0f));
+        }
+
+        void createScopePath(Path& path, SignalProbe& probe, Rectangle<float> bounds) const
+        {
+            // Show the most recent part of the history, one sample per pixel
+            auto numSamples = std::min<int>(static_cast<int>(bounds.getWidth()), SignalProbe::fftSize);
+            auto start = probe.historyPosition - numSamples + SignalProbe::fftSize;
+            auto centre = bounds.getCentreY();
+            auto halfHeight = bounds.getHeight() * 0.5f - 1.0f;
+
+            for (int i = 0; i < numSamples; i++) {
+                auto sample = jlimit(-1.0f, 1.0f, probe.history[(start + i) % SignalProbe::fftSize]);
+                auto point = Point<float>(bounds.getX() + i, centre - sample * halfHeight);
+                if (i == 0)
+                    path.startNewSubPath(point);
+                else
+                    path.lineTo(point);
+            }
+        }
+
+        void createSpectrumPath(Path& path, SignalProbe& probe, Rectangle<float> bounds) const
+        {
+            // Logarithmic frequency axis from 20 Hz to nyquist, -96 to 0 dB
+            auto nyquist = panel.probeManager.getSampleRate() * 0.5f;
+            auto const minFrequency = 20.0f;
+            auto logRange = std::log(nyquist / minFrequency);
+            auto width = static_cast<int>(bounds.getWidth());
+
+            for (int x = 0; x < width; x++) {
+                auto frequency = minFrequency * std::exp(logRange * x / static_cast<float>(width));
+                auto bin = jlimit(0, SignalProbe::numBins - 1, roundToInt(frequency / nyquist * SignalProbe::numBins));
+                auto level = jmap(jlimit(-96.0f, 0.0f, probe.spectrum[bin]), -96.0f, 0.0f, bounds.getBottom(), bounds.getY());
+                auto point = Point<float>(bounds.getX() + x, level);
+                if (x == 0)
+                    path.startNewSubPath(point);
+                else
+                    path.lineTo(point);
+            }
+        }
+
+        SignalProbePanel& panel;
+    };
+
+public:
+    static constexpr int panelWidth = 280;
+    static constexpr int headerHeight = 20;
+    static constexpr int rowHeight = 72;
+    static constexpr int maxVisibleRows = 5;
+
+    explicit SignalProbePanel(SignalProbeManager& manager)
+        : probeManager(manager)
+        , probeList(*this)
+    {
+        modeButton.setClickingTogglesState(true);
+        modeButton.onClick = [this]() {
+            showSpectrum = modeButton.getToggleState();
+            modeButton.setButtonText(showSpectrum ? "Spectrum" : "Scope");
+            probeList.repaint();
+        };
+        clearButton.onClick = [this]() {
+            probeManager.clear();
+        };
+
+        addAndMakeVisible(modeButton);
+        addAndMakeVisible(clearButton);
+
+        viewport.setViewedComponent(&probeList, false);
+        viewport.setScrollBarsShown(true, false);
+        addAndMakeVisible(viewport);
+
+        probeManager.addListener(this);
+        signalProbesChanged();
+    }
+
+    ~SignalProbePanel() override
+    {
+        probeManager.removeListener(this);
+    }
+
+    // Called by the editor after the layout changes
+    std::function<void()> onSizeChanged = []() {};
+
+    void signalProbesChanged() override
+    {
+        auto numProbes = probeManager.getNumProbes();
+        probeList.setSize(panelWidth - viewport.getScrollBarThickness(), numProbes * rowHeight);
+        setSize(panelWidth, headerHeight + 8 + std::min(numProbes, maxVisibleRows) * rowHeight);
+        setVisible(numProbes > 0);
+        onSizeChanged();
+        repaint();
+    }
+
+    void signalProbesUpdated() override
+    {
+        if (isShowing())
+            probeList.repaint();
+    }
+
+    void resized() override
+    {
+        auto bounds = getLocalBounds().reduced(4);
+        auto header = bounds.removeFromTop(headerHeight);
+        clearButton.setBounds(header.removeFromRight(50));
+        modeButton.setBounds(header.removeFromRight(70));
+        viewport.setBounds(bounds);
+    }
+
+    void paint(Graphics& g) override
+    {
+        auto bounds = getLocalBounds().toFloat().reduced(0.5f);
+        g.setColour(findColour(PlugDataColour::dialogBackgroundColourId));
+        g.fillRoundedRectangle(bounds, Corners::defaultCornerRadius);
+        g.setColour(findColour(PlugDataColour::outlineColourId));
+        g.drawRoundedRectangle(bounds, Corners::defaultCornerRadius, 1.0f);
+
+        auto title = "Signal probes (" + String(probeManager.getNumProbes()) + "/" + String(SignalProbeManager::maxProbedChannels) + ")";
+        g.setColour(findColour(PlugDataColour::panelTextColourId));
+        g.setFont(Fonts::getSemiBoldFont().withHeight(13.f));
+        g.drawText(title, getLocalBounds().reduced(10, 4).removeFromTop(headerHeight), Justification::centredLeft);
+    }
+
+private:
+    SignalProbeManager& probeManager;
+    bool showSpectrum = false;
+
+    TextButton modeButton = TextButton("Scope");
+    TextButton clearButton = TextButton("Clear");
+
+    ProbeList probeList;
+    Viewport viewport;
+};
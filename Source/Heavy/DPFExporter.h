@@ -26,6 +26,7 @@ public:
     {
         Array<PropertiesPanelProperty*> properties;
         properties.add(new PropertiesPanel::ComboComponent("Export type", exportTypeValue, { "Source code", "Binary" }));
+        properties.add(new PropertiesPanel::BoolComponent("Compiler cache", compilerCacheValue, { "No", "Yes" }));
         properties.add(new PropertiesPanel::ComboComponent("Plugin type", pluginTypeValue, { "Effect", "Instrument", "Custom" }));
 
         midiinProperty = new PropertiesPanel::BoolComponent("Midi Input", midiinEnableValue, { "No", "yes" });
@@ -76,6 +77,7 @@ public:
         stateTree.setProperty("jackEnableValue", getValue<int>(jackEnableValue), nullptr);
         stateTree.setProperty("exportTypeValue", getValue<int>(exportTypeValue), nullptr);
         stateTree.setProperty("pluginTypeValue", getValue<int>(pluginTypeValue), nullptr);
+        stateTree.setProperty("compilerCacheValue", getValue<int>(compilerCacheValue), nullptr);
 
         return stateTree;
     }
@@ -95,6 +97,8 @@ public:
         jackEnableValue = tree.getProperty("jackEnableValue");
         exportTypeValue = tree.getProperty("exportTypeValue");
         pluginTypeValue = tree.getProperty("pluginTypeValue");
+        if (tree.hasProperty("compilerCacheValue"))
+            compilerCacheValue = tree.getProperty("compilerCacheValue");
     }
 
     void valueChanged(Value& v) override
@@ -118,7 +122,7 @@ public:
     {
         exportingView->showState(ExportingProgressView::Busy);
 
-        StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + outdir };
+        StringArray args = { heavyExecutable.getFullPathName(), pdPatch };
 
         name = name.replaceCharacter('-', '_');
         args.add("-n" + name);
@@ -183,54 +187,62 @@ public:
         if (shouldQuit)
             return true;
 
-        start(args.joinIntoString(" "));
+        auto outputFile = File(outdir);
+        auto buildDir = getBuildDirectory("DPF", name);
 
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        bool regenerated;
+        bool generationExitCode = generateIncrementally(args, pdPatch, searchPaths, buildDir, { "dpf", "build", "bin" }, regenerated);
 
         if (shouldQuit)
             return true;
 
-        auto outputFile = File(outdir);
-        outputFile.getChildFile("ir").deleteRecursively();
-        outputFile.getChildFile("hv").deleteRecursively();
-        outputFile.getChildFile("c").deleteRecursively();
-
         auto DPF = Toolchain::dir.getChildFile("lib").getChildFile("dpf");
-        DPF.copyDirectoryTo(outputFile.getChildFile("dpf"));
+        syncLibrary(DPF, buildDir.getChildFile("dpf"), regenerated);
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
+        // Source code export, without heavy's intermediate files
+        if (!generationExitCode && getValue<int>(exportTypeValue) == 1) {
+            syncDirectory(buildDir, outputFile, { "ir", "hv", "c", "build", "bin" }, false);
+        }
 
-        bool generationExitCode = getExitCode();
         // Check if we need to compile
         if (!generationExitCode && getValue<int>(exportTypeValue) == 2) {
             auto workingDir = File::getCurrentWorkingDirectory();
 
-            outputFile.setAsCurrentWorkingDirectory();
+            // The build folder is kept between exports, so make only rebuilds what changed
+            buildDir.setAsCurrentWorkingDirectory();
 
             auto bin = Toolchain::dir.getChildFile("bin");
             auto make = bin.getChildFile("make" + exeSuffix);
-            auto makefile = outputFile.getChildFile("Makefile");
+            auto makefile = buildDir.getChildFile("Makefile");
+            auto launcher = getCompilerLauncher();
 
 #if JUCE_MAC
-            Toolchain::startShellScript("make -j4 -f " + makefile.getFullPathName(), this);
+            auto compilers = launcher.isEmpty() ? String() : "CC=\"" + launcher + " cc\" CXX=\"" + launcher + " c++\" ";
+            Toolchain::startShellScript("make" + getMakeJobs() + compilers + "-f " + makefile.getFullPathName(), this);
 #elif JUCE_WINDOWS
             auto path = "export PATH=\"$PATH:" + Toolchain::dir.getChildFile("bin").getFullPathName().replaceCharacter('\\', '/') + "\"\n";
-            auto cc = "CC=" + Toolchain::dir.getChildFile("bin").getChildFile("gcc.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
-            auto cxx = "CXX=" + Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
+            auto gcc = Toolchain::dir.getChildFile("bin").getChildFile("gcc.exe").getFullPathName().replaceCharacter('\\', '/');
+            auto gxx = Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/');
+            if (launcher.isNotEmpty()) {
+                gcc = launcher + " " + gcc;
+                gxx = launcher + " " + gxx;
+            }
+
+            auto cc = "CC=\"" + gcc + "\" ";
+            auto cxx = "CXX=\"" + gxx + "\" ";
 
-            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + " -j4 -f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
+            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + getMakeJobs() + "-f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
 
 #else // Linux or BSD
             auto prepareEnvironmentScript = Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getFullPathName() + "\n";
+            auto compilers = launcher.isEmpty() ? String() : "CC=\"" + launcher + " ${CC:-cc}\" CXX=\"" + launcher + " ${CXX:-c++}\" ";
 
             auto buildScript = prepareEnvironmentScript
                 + make.getFullPathName()
-                + " -j4 -f " + makefile.getFullPathName();
+                + getMakeJobs() + compilers + "-f " + makefile.getFullPathName();
 
             // For some reason we need to do this again
-            outputFile.getChildFile("dpf").getChildFile("utils").getChildFile("generate-ttl.sh").setExecutePermission(true);
+            buildDir.getChildFile("dpf").getChildFile("utils").getChildFile("generate-ttl.sh").setExecutePermission(true);
             Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getChildFile("generate-ttl.sh").setExecutePermission(true);
 
             Toolchain::startShellScript(buildScript, this);
@@ -244,36 +256,34 @@ public:
 
             workingDir.setAsCurrentWorkingDirectory();
 
-            // Copy output
-            if (lv2)
-                outputFile.getChildFile("bin").getChildFile(name + ".lv2").copyDirectoryTo(outputFile.getChildFile(name + ".lv2"));
-            if (vst3)
-                outputFile.getChildFile("bin").getChildFile(name + ".vst3").copyDirectoryTo(outputFile.getChildFile(name + ".vst3"));
+            bool compilationExitCode = getExitCode();
+
+            // Copy output, the build folder keeps its own copy so the next build can be incremental
+            if (!compilationExitCode) {
+                auto buildOutput = buildDir.getChildFile("bin");
+                if (lv2)
+                    buildOutput.getChildFile(name + ".lv2").copyDirectoryTo(outputFile.getChildFile(name + ".lv2"));
+                if (vst3)
+                    buildOutput.getChildFile(name + ".vst3").copyDirectoryTo(outputFile.getChildFile(name + ".vst3"));
 #if JUCE_WINDOWS
-            if (vst2)
-                outputFile.getChildFile("bin").getChildFile(name + "-vst.dll").moveFileTo(outputFile.getChildFile(name + "-vst.dll"));
+                if (vst2)
+                    buildOutput.getChildFile(name + "-vst.dll").copyFileTo(outputFile.getChildFile(name + "-vst.dll"));
 #elif JUCE_LINUX
-            if (vst2)
-                outputFile.getChildFile("bin").getChildFile(name + "-vst.so").moveFileTo(outputFile.getChildFile(name + "-vst.so"));
+                if (vst2)
+                    buildOutput.getChildFile(name + "-vst.so").copyFileTo(outputFile.getChildFile(name + "-vst.so"));
 #elif JUCE_MAC
-            if (vst2)
-                outputFile.getChildFile("bin").getChildFile(name + ".vst").copyDirectoryTo(outputFile.getChildFile(name + ".vst"));
+                if (vst2)
+                    buildOutput.getChildFile(name + ".vst").copyDirectoryTo(outputFile.getChildFile(name + ".vst"));
 #endif
-            if (clap)
-                outputFile.getChildFile("bin").getChildFile(name + ".clap").moveFileTo(outputFile.getChildFile(name + ".clap"));
-            if (jack)
-                outputFile.getChildFile("bin").getChildFile(name).moveFileTo(outputFile.getChildFile(name));
-
-            bool compilationExitCode = getExitCode();
-
-            // Clean up if successful
-            if (!compilationExitCode) {
-                outputFile.getChildFile("dpf").deleteRecursively();
-                outputFile.getChildFile("build").deleteRecursively();
-                outputFile.getChildFile("plugin").deleteRecursively();
-                outputFile.getChildFile("bin").deleteRecursively();
-                outputFile.getChildFile("README.md").deleteFile();
-                outputFile.getChildFile("Makefile").deleteFile();
+                if (clap) {
+                    auto clapOutput = buildOutput.getChildFile(name + ".clap");
+                    if (clapOutput.isDirectory())
+                        clapOutput.copyDirectoryTo(outputFile.getChildFile(name + ".clap"));
+                    else
+                        clapOutput.copyFileTo(outputFile.getChildFile(name + ".clap"));
+                }
+                if (jack)
+                    buildOutput.getChildFile(name).copyFileTo(outputFile.getChildFile(name));
             }
 
             return compilationExitCode;
@@ -44,6 +44,7 @@ public:
         properties.add(new PropertiesPanel::ComboComponent("Patch size", patchSizeValue, { "Small", "Big", "Huge", "Custom Linker..." }));
         appTypeProperty = new PropertiesPanel::ComboComponent("App type", appTypeValue, { "SRAM", "QSPI" });
         properties.add(appTypeProperty);
+        properties.add(new PropertiesPanel::BoolComponent("Compiler cache", compilerCacheValue, { "No", "Yes" }));
 
         for (auto* property : properties) {
             property->setPreferredHeight(28);
@@ -91,6 +92,7 @@ public:
         stateTree.setProperty("patchSizeValue", getValue<int>(patchSizeValue), nullptr);
         stateTree.setProperty("appTypeValue", getValue<int>(appTypeValue), nullptr);
         stateTree.setProperty("customLinkerValue", customLinker.getFullPathName(), nullptr);
+        stateTree.setProperty("compilerCacheValue", getValue<int>(compilerCacheValue), nullptr);
         return stateTree;
     }
 
@@ -112,6 +114,8 @@ public:
         patchSizeValue = tree.getProperty("patchSizeValue");
         appTypeValue = tree.getProperty("appTypeValue");
         customLinker = File(tree.getProperty("customLinkerValue").toString());
+        if (tree.hasProperty("compilerCacheValue"))
+            compilerCacheValue = tree.getProperty("compilerCacheValue");
     }
 
     void resized() override
@@ -190,7 +194,7 @@ public:
         auto size = getValue<int>(patchSizeValue);
         auto appType = getValue<int>(appTypeValue);
 
-        StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + outdir };
+        StringArray args = { heavyExecutable.getFullPathName(), pdPatch };
 
         name = name.replaceCharacter('-', '_');
         args.add("-n" + name);
@@ -270,57 +274,54 @@ public:
 
         args.add(paths);
 
-        start(args.joinIntoString(" "));
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        auto outputFile = File(outdir);
+        auto buildDir = getBuildDirectory("Daisy", name);
+        auto sourceDir = buildDir.getChildFile("daisy").getChildFile("source");
 
-        exportingView->logToConsole("Compiling for " + board + "...\n");
+        bool regenerated;
+        bool heavyExitCode = generateIncrementally(args, pdPatch, searchPaths, buildDir, { "libdaisy", "daisy/source/build" }, regenerated);
 
         if (shouldQuit)
             return true;
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
-
-        auto outputFile = File(outdir);
-        auto sourceDir = outputFile.getChildFile("daisy").getChildFile("source");
+        auto libDaisy = Toolchain::dir.getChildFile("lib").getChildFile("libdaisy");
+        syncLibrary(libDaisy, buildDir.getChildFile("libdaisy"), regenerated);
 
-        bool heavyExitCode = getExitCode();
-
-        if (compile) {
+        if (compile && !heavyExitCode) {
+            exportingView->logToConsole("Compiling for " + board + "...\n");
 
             auto bin = Toolchain::dir.getChildFile("bin");
-            auto libDaisy = Toolchain::dir.getChildFile("lib").getChildFile("libdaisy");
             auto make = bin.getChildFile("make" + exeSuffix);
-            auto compiler = bin.getChildFile("arm-none-eabi-gcc" + exeSuffix);
-
-            libDaisy.copyDirectoryTo(outputFile.getChildFile("libdaisy"));
-
-            outputFile.getChildFile("ir").deleteRecursively();
-            outputFile.getChildFile("hv").deleteRecursively();
-            outputFile.getChildFile("c").deleteRecursively();
 
             auto workingDir = File::getCurrentWorkingDirectory();
 
+            // The build folder is kept between exports, so make only rebuilds what changed
             sourceDir.setAsCurrentWorkingDirectory();
 
             sourceDir.getChildFile("build").createDirectory();
             auto const& gccPath = bin.getFullPathName();
+            auto launcher = getCompilerLauncher();
 
 #if JUCE_WINDOWS
+            auto compilers = launcher.isEmpty() ? String() : " CC=\"" + launcher + " " + gccPath.replaceCharacter('\\', '/') + "/arm-none-eabi-gcc\" CXX=\"" + launcher + " " + gccPath.replaceCharacter('\\', '/') + "/arm-none-eabi-g++\"";
+
             auto buildScript = make.getFullPathName().replaceCharacter('\\', '/')
-                + " -j4 -f "
+                + getMakeJobs() + "-f "
                 + sourceDir.getChildFile("Makefile").getFullPathName().replaceCharacter('\\', '/')
                 + " GCC_PATH="
                 + gccPath.replaceCharacter('\\', '/')
-                + " PROJECT_NAME=" + name;
+                + " PROJECT_NAME=" + name
+                + compilers;
 
             Toolchain::startShellScript(buildScript, this);
 #else
+            auto compilers = launcher.isEmpty() ? String() : " CC=\"" + launcher + " " + gccPath + "/arm-none-eabi-gcc\" CXX=\"" + launcher + " " + gccPath + "/arm-none-eabi-g++\"";
+
             String buildScript = make.getFullPathName()
-                + " -j4 -f " + sourceDir.getChildFile("Makefile").getFullPathName()
+                + getMakeJobs() + "-f " + sourceDir.getChildFile("Makefile").getFullPathName()
                 + " GCC_PATH=" + gccPath
-                + " PROJECT_NAME=" + name;
+                + " PROJECT_NAME=" + name
+                + compilers;
 
             Toolchain::startShellScript(buildScript, this);
 #endif
@@ -421,25 +422,19 @@ public:
 
                 auto flashExitCode = getExitCode();
 
-                return heavyExitCode && flashExitCode;
-            } else {
+                return flashExitCode;
+            } else if (!compileExitCode) {
+                // The build folder keeps its own copy, so the next build can be incremental
                 auto binLocation = outputFile.getChildFile(name + ".bin");
-                sourceDir.getChildFile("build").getChildFile("HeavyDaisy_" + name + ".bin").moveFileTo(binLocation);
+                sourceDir.getChildFile("build").getChildFile("HeavyDaisy_" + name + ".bin").copyFileTo(binLocation);
             }
 
-            outputFile.getChildFile("daisy").deleteRecursively();
-            outputFile.getChildFile("libdaisy").deleteRecursively();
-
-            return heavyExitCode && compileExitCode;
+            return compileExitCode;
         } else {
-            auto outputFile = File(outdir);
-
-            auto libDaisy = Toolchain::dir.getChildFile("lib").getChildFile("libdaisy");
-            libDaisy.copyDirectoryTo(outputFile.getChildFile("libdaisy"));
+            // Source code export, without heavy's intermediate files
+            if (!heavyExitCode)
+                syncDirectory(buildDir, outputFile, { "ir", "hv", "c", "daisy/source/build" }, false);
 
-            outputFile.getChildFile("ir").deleteRecursively();
-            outputFile.getChildFile("hv").deleteRecursively();
-            outputFile.getChildFile("c").deleteRecursively();
             return heavyExitCode;
         }
     }
@@ -4,6 +4,9 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
+#include <set>
+#include <juce_cryptography/juce_cryptography.h>
+
 #include "PluginEditor.h"
 #include "Pd/Patch.h"
 
@@ -16,6 +19,7 @@ struct ExporterBase : public Component
     Value inputPatchValue;
     Value projectNameValue;
     Value projectCopyrightValue;
+    Value compilerCacheValue = Value(var(0));
 
 #if JUCE_WINDOWS
     inline static String const exeSuffix = ".exe";
@@ -31,6 +35,10 @@ struct ExporterBase : public Component
     File openedPatchFile;
     File realPatchFile;
 
+    // The patch the current export job is for, the currently opened patch is exported from a new temporary copy
+    // every time, so this points to the file it was saved as instead
+    File sourcePatchFile;
+
     PropertiesPanel panel;
 
     ExportingProgressView* exportingView;
@@ -155,7 +163,10 @@ struct ExporterBase : public Component
         // Make sure we don't add the file location twice
         searchPaths.removeDuplicates(false);
 
-        addJob([this, patchPath, outPath, projectTitle, projectCopyright, searchPaths]() mutable {
+        auto sourcePatch = patchFile == openedPatchFile ? realPatchFile : patchFile;
+
+        addJob([this, patchPath, outPath, projectTitle, projectCopyright, searchPaths, sourcePatch]() mutable {
+            sourcePatchFile = sourcePatch;
             exportingView->monitorProcessOutput(this);
 
             exportingView->showState(ExportingProgressView::Busy);
@@ -216,6 +227,222 @@ struct ExporterBase : public Component
         return metadata.getFullPathName();
     }
 
+    // Exports that compile are generated and built in a folder that is kept between exports of the same project
+    // The folder is found by the patch file and project name, unsaved patches only by their project name
+    // It's outside of the app data folder, so builds don't wake up the file watchers
+    File getBuildDirectory(String const& exporterName, String const& name) const
+    {
+        auto patchKey = sourcePatchFile.existsAsFile() ? sourcePatchFile.getFullPathName() : String();
+        auto projectKey = String::toHexString((exporterName + patchKey + name).hashCode64());
+
+        auto buildsDir = File::getSpecialLocation(File::tempDirectory).getChildFile("plugdata-heavy-builds");
+        auto buildDir = buildsDir.getChildFile(projectKey);
+
+        buildDir.createDirectory();
+        buildDir.setLastModificationTime(Time::getCurrentTime());
+        pruneBuildDirectories(buildsDir, buildDir);
+
+        return buildDir;
+    }
+
+    // Removes the build folders that weren't used for a while, and the least recently used ones if there are too many
+    static void pruneBuildDirectories(File const& buildsDir, File const& currentBuildDir)
+    {
+        constexpr int maxBuildDirectories = 8;
+        constexpr int maxAgeInDays = 30;
+
+        auto buildDirs = buildsDir.findChildFiles(File::findDirectories, false);
+        std::sort(buildDirs.begin(), buildDirs.end(), [](File const& a, File const& b) {
+            return a.getLastModificationTime() > b.getLastModificationTime();
+        });
+
+        auto oldest = Time::getCurrentTime() - RelativeTime::days(maxAgeInDays);
+        for (int i = 0; i < buildDirs.size(); i++) {
+            auto const& buildDir = buildDirs.getReference(i);
+            if (buildDir != currentBuildDir && (i >= maxBuildDirectories || buildDir.getLastModificationTime() < oldest))
+                buildDir.deleteRecursively();
+        }
+    }
+
+    // Hashes everything that affects the generated code: the patch, every abstraction it uses, the heavy arguments,
+    // the contents of the metadata file and the heavy version
+    // The exported patch is hashed by its content only, since the currently opened patch is a new temporary file
+    // every time
+    static String hashExportInputs(String const& pdPatch, StringArray const& args, StringArray const& searchPaths)
+    {
+        MemoryOutputStream inputs;
+
+        for (auto const& arg : args) {
+            // The output folder doesn't change the result, and the metadata file is a new temporary file every time
+            if (arg.startsWith("-o") || arg == pdPatch)
+                continue;
+
+            inputs << (arg.startsWith("-m") ? File(arg.substring(2)).loadFileAsString() : arg) << "\n";
+        }
+
+        inputs << heavyExecutable.getLastModificationTime().toMilliseconds() << "\n";
+
+        // Follow the abstractions the patch uses, looking for them the same way pd does: next to the patch that uses
+        // them first, then in the search paths
+        std::set<String> visited;
+        std::function<void(File const&)> addPatch = [&](File const& patch) {
+            if (!visited.insert(patch.getFullPathName()).second)
+                return;
+
+            auto content = patch.loadFileAsString();
+            if (patch != File(pdPatch))
+                inputs << patch.getFullPathName() << "\n";
+            inputs << content << "\n";
+
+            for (auto const& line : StringArray::fromTokens(content, ";", "")) {
+                auto tokens = StringArray::fromTokens(line.trim(), " \n", "");
+                if (tokens.size() < 5 || tokens[0] != "#X" || tokens[1] != "obj")
+                    continue;
+
+                auto abstractionName = tokens[4] + ".pd";
+                auto candidates = StringArray { patch.getParentDirectory().getFullPathName() };
+                candidates.addArray(searchPaths);
+
+                for (auto const& directory : candidates) {
+                    auto abstraction = File(directory).getChildFile(abstractionName);
+                    if (abstraction.existsAsFile()) {
+                        addPatch(abstraction);
+                        break;
+                    }
+                }
+            }
+        };
+
+        addPatch(File(pdPatch));
+
+        return SHA256(inputs.getData(), inputs.getDataSize()).toHexString();
+    }
+
+    // Runs heavy into a temporary folder and merges the output into the build folder. Generated files that didn't
+    // change keep their modification time, so make only rebuilds what changed
+    // Heavy isn't run at all if nothing changed since the last successful generation
+    // Returns true on failure, like getExitCode
+    bool generateIncrementally(StringArray args, String const& pdPatch, StringArray const& searchPaths, File const& buildDir, StringArray const& buildOutputs, bool& regenerated)
+    {
+        regenerated = false;
+
+        auto inputsHash = hashExportInputs(pdPatch, args, searchPaths);
+        auto hashFile = buildDir.getChildFile(".export_hash");
+
+        if (buildDir.isDirectory() && hashFile.loadFileAsString() == inputsHash) {
+            exportingView->logToConsole("Patch unchanged, skipping code generation\n");
+            return false;
+        }
+
+        hashFile.deleteFile();
+
+        auto generatedDir = File::createTempFile("heavy");
+        generatedDir.createDirectory();
+        args.add("-o" + generatedDir.getFullPathName());
+
+        start(args.joinIntoString(" "));
+        waitForProcessToFinish(-1);
+        exportingView->flushConsole();
+
+        // Delay to get correct exit code
+        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
+
+        bool exitCode = getExitCode();
+        if (!exitCode && !shouldQuit) {
+            buildDir.createDirectory();
+            syncDirectory(generatedDir, buildDir, buildOutputs, true);
+            hashFile.replaceWithText(inputsHash);
+            regenerated = true;
+        }
+
+        generatedDir.deleteRecursively();
+        return exitCode;
+    }
+
+    // Copies the files that are different or missing in the target. Paths in excluded (relative to the source and
+    // target) and hidden files at the top level are skipped. If removeStale is set, files in the target that aren't
+    // in the source are removed
+    static void syncDirectory(File const& source, File const& target, StringArray const& excluded, bool removeStale)
+    {
+        auto isExcluded = [&excluded](String const& relativePath) {
+            return std::any_of(excluded.begin(), excluded.end(), [&relativePath](String const& path) {
+                return relativePath == path || relativePath.startsWith(path + "/");
+            });
+        };
+
+        for (auto const& file : source.findChildFiles(File::findFiles, true)) {
+            auto relativePath = file.getRelativePathFrom(source).replaceCharacter('\\', '/');
+            if (isExcluded(relativePath) || relativePath.startsWith("."))
+                continue;
+
+            auto targetFile = target.getChildFile(relativePath);
+            if (targetFile.existsAsFile() && targetFile.getSize() == file.getSize() && targetFile.hasIdenticalContentTo(file))
+                continue;
+
+            targetFile.getParentDirectory().createDirectory();
+            file.copyFileTo(targetFile);
+        }
+
+        if (!removeStale)
+            return;
+
+        for (auto const& file : target.findChildFiles(File::findFiles, true)) {
+            auto relativePath = file.getRelativePathFrom(target).replaceCharacter('\\', '/');
+            if (!isExcluded(relativePath) && !relativePath.startsWith(".") && !source.getChildFile(relativePath).existsAsFile())
+                file.deleteFile();
+        }
+    }
+
+    // Libraries are only copied into the build folder once, and refreshed when the code was generated again (that
+    // includes toolchain updates), so their objects aren't rebuilt every time
+    static void syncLibrary(File const& library, File const& target, bool refresh)
+    {
+        if (!target.isDirectory())
+            library.copyDirectoryTo(target);
+        else if (refresh)
+            syncDirectory(library, target, {}, false);
+    }
+
+    static String getMakeJobs()
+    {
+        return " -j" + String(jmax(1, SystemStats::getNumCpus())) + " ";
+    }
+
+    // ccache or sccache, if it's installed and enabled
+    String getCompilerLauncher()
+    {
+        if (!getValue<bool>(compilerCacheValue))
+            return {};
+
+#if JUCE_WINDOWS
+        auto separator = ";";
+#else
+        auto separator = ":";
+#endif
+
+        auto searchPaths = StringArray::fromTokens(SystemStats::getEnvironmentVariable("PATH", {}), separator, "");
+        searchPaths.insert(0, Toolchain::dir.getChildFile("bin").getFullPathName());
+#if JUCE_MAC
+        // Apps started from the Finder don't get the shell's PATH
+        searchPaths.addArray({ "/opt/homebrew/bin", "/usr/local/bin" });
+#endif
+
+        for (auto const& launcher : { "ccache", "sccache" }) {
+            for (auto const& path : searchPaths) {
+                if (!File::isAbsolutePath(path))
+                    continue;
+
+                auto executable = File(path).getChildFile(launcher + exeSuffix);
+                if (executable.existsAsFile()) {
+                    exportingView->logToConsole("Using " + String(launcher) + " to cache compilation\n");
+                    return executable.getFullPathName().replaceCharacter('\\', '/');
+                }
+            }
+        }
+
+        return {};
+    }
+
 private:
     virtual bool performExport(String pdPatch, String outdir, String name, String copyright, StringArray searchPaths) = 0;
 };
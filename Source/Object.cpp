@@ -112,16 +112,28 @@ void Object::initialise()
     updateOverlays(cnv->getOverlays());
 }
 
-void Object::timerCallback()
+void Object::frameTimerCallback()
 {
     activeStateAlpha -= 0.16f;
     repaint();
     if (activeStateAlpha <= 0.0f) {
         activeStateAlpha = 0.0f;
-        stopTimer();
+        stopFrameTimer();
     }
 }
 
+bool Object::isFrameTimerVisible()
+{
+    // Let the glow fade out while hidden, so it doesn't show up again when we become visible
+    if (!isShowing()) {
+        activeStateAlpha = 0.0f;
+        stopFrameTimer();
+        return false;
+    }
+
+    return true;
+}
+
 void Object::changeListenerCallback(ChangeBroadcaster* source)
 {
     if (auto selectedItems = dynamic_cast<SelectedItemSet<WeakReference<Component>>*>(source))
@@ -474,7 +486,7 @@ void Object::triggerOverlayActiveState()
         return;
 
     activeStateAlpha = 1.0f;
-    startTimer(1000 / ACTIVITY_UPDATE_RATE);
+    startFrameTimer(1000 / ACTIVITY_UPDATE_RATE);
 
     // Because the timer is being reset when new messages come in
     // it will not trigger it's callback until it's free-running
@@ -489,7 +501,7 @@ void Object::paint(Graphics& g)
         
         g.fillRoundedRectangle(getLocalBounds().reduced(Object::margin).toFloat(), Corners::objectCornerRadius);
     }
-    if ((showActiveState || isTimerRunning())) {
+    if ((showActiveState || isFrameTimerRunning())) {
         g.setOpacity(activeStateAlpha);
         // show activation state glow
         g.drawImage(activityOverlayImage, getLocalBounds().toFloat());
@@ -1220,6 +1232,10 @@ void Object::hideEditor()
 
         repaint();
         setType(newText);
+
+        // Typos and objects that failed to create shouldn't rank higher in autocomplete
+        if (newText.isNotEmpty() && gui && gui->getType() != "invalid")
+            cnv->pd->objectLibrary->recordObjectUsage(newText.upToFirstOccurrenceOf(" ", false, false));
     }
 }
 
@@ -10,6 +10,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "Utility/SettingsFile.h"
 #include "Utility/RateReducer.h"
+#include "Utility/FrameScheduler.h"
 #include "Pd/WeakReference.h"
 
 #define ACTIVITY_UPDATE_RATE 15
@@ -24,7 +25,7 @@ class ObjectBoundsConstrainer;
 class Object : public Component
     , public Value::Listener
     , public ChangeListener
-    , public Timer
+    , public FrameTimer
     , private TextEditor::Listener {
 public:
     Object(Canvas* parent, String const& name = "", Point<int> position = { 100, 100 });
@@ -36,7 +37,8 @@ public:
     void valueChanged(Value& v) override;
 
     void changeListenerCallback(ChangeBroadcaster* source) override;
-    void timerCallback() override;
+    void frameTimerCallback() override;
+    bool isFrameTimerVisible() override;
 
     void paint(Graphics&) override;
     void paintOverChildren(Graphics&) override;
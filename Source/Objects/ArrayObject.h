@@ -5,13 +5,14 @@
  */
 
 #include "Components/PropertiesPanel.h"
+#include "Utility/MinMaxPyramid.h"
 
 extern "C" {
 void garray_arraydialog(t_fake_garray* x, t_symbol* name, t_floatarg fsize, t_floatarg fflags, t_floatarg deleteit);
 }
 
 
-class GraphicalArray : public Component, public Value::Listener, public pd::MessageListener {
+class GraphicalArray : public Component, public Value::Listener, public pd::MessageListener, public FrameTimer {
 public:
     Object* object;
 
@@ -32,16 +33,16 @@ public:
     GraphicalArray(PluginProcessor* instance, void* ptr, Object* parent)
         : object(parent)
         , arr(ptr, instance)
-        , edited(false)
         , pd(instance)
     {
         vec.reserve(8192);
-        temp.reserve(8192);
         try {
             read(vec);
         } catch (...) {
             error = true;
         }
+
+        pyramid.build(vec.data(), static_cast<int>(vec.size()));
         
         updateParameters();
         
@@ -55,6 +56,8 @@ public:
 
         setInterceptsMouseClicks(true, false);
         setOpaque(false);
+
+        startFrameTimerHz(60);
     }
     
     ~GraphicalArray()
@@ -74,35 +77,16 @@ public:
 
         // Initialise new weakreference in place, to prevent calling copy constructor
         new (&arr) pd::WeakReference(array, pd);
-    }
-
-    std::vector<float> rescale(std::vector<float> const& v, unsigned const newSize)
-    {
-        if (v.empty()) {
-            return {};
-        }
-
-        std::vector<float> result(newSize);
-        const std::size_t oldSize = v.size();
-        for (unsigned i = 0; i < newSize; i++) {
-            auto const idx = i * (oldSize - 1) / newSize;
-            auto const mod = i * (oldSize - 1) % newSize;
 
-            if (mod == 0)
-                result[i] = v[idx];
-            else {
-                float const part = float(mod) / float(newSize);
-                result[i] = v[idx] * (1.0 - part) + v[idx + 1] * part;
-            }
-        }
-        return result;
+        // Edits queued for the old array won't tell us when they're done if it was deleted
+        pendingEdits = std::make_shared<std::atomic<int>>(isDragging ? 1 : 0);
     }
 
     void paintGraph(Graphics& g)
     {
         auto const h = static_cast<float>(getHeight());
         auto const w = static_cast<float>(getWidth());
-        std::vector<float> points = vec;
+        auto const& points = vec;
 
         if (!points.empty()) {
             std::array<float, 2> scale = getScale();
@@ -113,13 +97,47 @@ public:
                 std::swap(scale[0], scale[1]);
             }
 
-            // More than a point per pixel will cause insane loads, and isn't actually helpful
-            // Instead, linearly interpolate the vector to a max size of width in pixels
-            if (vec.size() >= w) {
-                points = rescale(points, w);
+            float const dh = h / (scale[1] - scale[0]);
+
+            // Well over a point per pixel will cause insane loads, and isn't actually helpful
+            // Instead, draw the minimum and maximum value for each pixel, so peaks stay visible
+            if (points.size() >= w * 2) {
+                pyramid.getMinMax(points.data(), static_cast<int>(w), pixelRanges);
+
+                auto const lineWidth = static_cast<float>(getLineWidth());
+                auto const drawType = getDrawType();
+
+                Path p;
+                for (int x = 0; x < pixelRanges.size(); x++) {
+                    auto range = pixelRanges[x];
+
+                    // Lines are connected to the previous pixel, so steps in the signal don't leave gaps
+                    if (drawType != DrawType::Points && x > 0) {
+                        auto const& previous = pixelRanges[x - 1];
+                        auto const nearest = previous.clipValue(range.clipValue(previous.getStart()));
+                        range = range.getUnionWith(Range<float>(nearest, nearest));
+                    }
+
+                    float const top = h - (std::clamp(range.getEnd(), scale[0], scale[1]) - scale[0]) * dh;
+                    float const bottom = h - (std::clamp(range.getStart(), scale[0], scale[1]) - scale[0]) * dh;
+
+                    // Points only mark the highest and lowest point in each pixel
+                    if (drawType == DrawType::Points && bottom - top > lineWidth) {
+                        p.addRectangle(static_cast<float>(x), top - lineWidth * 0.5f, 1.0f, lineWidth);
+                        p.addRectangle(static_cast<float>(x), bottom - lineWidth * 0.5f, 1.0f, lineWidth);
+                    } else {
+                        p.addRectangle(static_cast<float>(x), top - lineWidth * 0.5f, 1.0f, bottom - top + lineWidth);
+                    }
+                }
+
+                if (invert)
+                    p.applyTransform(AffineTransform::verticalFlip(getHeight()));
+
+                g.setColour(getContentColour());
+                g.fillPath(p);
+                return;
             }
 
-            float const dh = h / (scale[1] - scale[0]);
             float const dw = w / static_cast<float>(points.size() - 1);
 
             switch (getDrawType()) {
@@ -252,7 +270,9 @@ public:
     {
         if (error || !getEditMode())
             return;
-        edited = true;
+
+        isDragging = true;
+        pendingEdits->fetch_add(1);
 
         auto const s = static_cast<float>(vec.size() - 1);
         auto const w = static_cast<float>(getWidth());
@@ -292,58 +312,101 @@ public:
             vec[n] = jmap<float>(n, interpStart, interpEnd + 1, min, max);
         }
 
+        pyramid.update(vec.data(), static_cast<int>(vec.size()), interpStart, interpEnd + 1);
+
         // Don't want to touch vec on the other thread, so we copy the vector into the lambda
         auto changed = std::vector<float>(vec.begin() + interpStart, vec.begin() + interpEnd + 1);
 
         lastIndex = index;
 
-        pd->lockAudioThread();
-        for (int n = 0; n < changed.size(); n++) {
-            write(interpStart + n, changed[n]);
-        }
+        // Queue the changed span to be written on the audio thread, so we don't need to take the audio lock while dragging
+        pd->enqueueFunctionAsync<t_garray>(arr, [pd = pd, changed, interpStart, message = stringArray](t_garray* garray) {
+            auto const arraySize = garray_getarray(garray)->a_n;
+            auto* vec = reinterpret_cast<t_word*>(garray_vec(garray));
+            for (int n = 0; n < changed.size() && interpStart + n < arraySize; n++) {
+                vec[interpStart + n].w_float = changed[n];
+            }
 
-        if (auto ptr = arr.get<t_fake_garray>()) {
-            pd->sendDirectMessage(ptr.get(), stringArray);
-        }
+            pd->sendDirectMessage(garray, message);
+        });
 
-        pd->unlockAudioThread();
         repaint();
     }
 
     void mouseUp(MouseEvent const& e) override
     {
-        if (error || !getEditMode())
+        if (!isDragging)
             return;
-        
-        if (auto ptr = arr.get<t_fake_garray>()) {
-            plugdata_forward_message(ptr->x_glist, gensym("redraw"), 0, NULL);
+
+        isDragging = false;
+
+        // This runs after all the writes we queued while dragging, so from here on reading back gives us our own values
+        // If the array is gone the function never runs, but then there's nothing left to read back either
+        pd->enqueueFunctionAsync<t_fake_garray>(arr, [pendingEdits = pendingEdits](t_fake_garray* garray) {
+            pendingEdits->fetch_sub(1);
+            plugdata_forward_message(garray->x_glist, gensym("redraw"), 0, NULL);
+        });
+    }
+
+    bool isFrameTimerVisible() override
+    {
+        return isShowing();
+    }
+
+    // Read the array back at most once per frame, no matter how many redraws Pd sent
+    void frameTimerCallback() override
+    {
+        if (needsUpdate.exchange(false)) {
+            update();
         }
-        
-        edited = false;
     }
 
+    // Reads the array from Pd, and updates the min/max pyramid for the values that changed
+    // Pd's redraw doesn't tell us which part of the array changed, so the whole array is copied under the lock. To keep
+    // that as short as possible, the copy is a plain loop into a scratch buffer and the comparison happens afterwards
     void update()
     {
-        // Check if size has changed
-        int currentSize = getArraySize();
-        if (vec.size() != currentSize) {
-            vec.resize(currentSize);
+        // Don't overwrite changes that we're making ourselves, read them back once they have been written
+        if (pendingEdits->load() > 0) {
+            needsUpdate = true;
+            return;
         }
-        
-        size = currentSize;
 
-        if (!edited) {
-            error = false;
-            try {
-                read(temp);
-            } catch (...) {
-                error = true;
-            }
-            if (temp != vec) {
-                vec.swap(temp);
-                repaint();
+        if (auto ptr = arr.get<t_garray>()) {
+            auto const currentSize = garray_getarray(ptr.get())->a_n;
+            readBuffer.resize(currentSize);
+
+            auto const* words = reinterpret_cast<t_word*>(garray_vec(ptr.get()));
+            for (int i = 0; i < currentSize; i++) {
+                readBuffer[i] = words[i].w_float;
             }
+        } else {
+            return;
+        }
+
+        auto const currentSize = static_cast<int>(readBuffer.size());
+        error = false;
+        size = currentSize;
+
+        if (vec.size() != readBuffer.size()) {
+            vec = readBuffer;
+            pyramid.build(vec.data(), currentSize);
+            repaint();
+            return;
         }
+
+        // Only the span between the first and last changed value is copied and updated in the pyramid
+        auto const first = std::mismatch(readBuffer.begin(), readBuffer.end(), vec.begin()).first;
+        if (first == readBuffer.end())
+            return;
+
+        auto const last = std::mismatch(readBuffer.rbegin(), readBuffer.rend(), vec.rbegin()).first.base();
+        auto const firstChanged = static_cast<int>(first - readBuffer.begin());
+        auto const endChanged = static_cast<int>(last - readBuffer.begin());
+
+        std::copy(first, last, vec.begin() + firstChanged);
+        pyramid.update(vec.data(), currentSize, firstChanged, endChanged);
+        repaint();
     }
 
     bool willSaveContent() const
@@ -569,20 +632,20 @@ public:
         }
     }
 
-    // Writes a value to the array.
-    void write(const size_t pos, float const input)
-    {
-        if (auto ptr = arr.get<t_garray>()) {
-            t_word* vec = ((t_word*)garray_vec(ptr.get()));
-            vec[pos].w_float = input;
-        }
-    }
-
     pd::WeakReference arr;
 
     std::vector<float> vec;
-    std::vector<float> temp;
-    std::atomic<bool> edited;
+    std::vector<float> readBuffer; // Reused, so reading the array doesn't allocate
+
+    // Set when Pd redraws the array, we read it back on the next frame
+    std::atomic<bool> needsUpdate = false;
+
+    MinMaxPyramid pyramid;
+    std::vector<Range<float>> pixelRanges;
+
+    // Drag gestures whose writes haven't all reached Pd yet. Shared with the queued writes, since they can outlive us
+    std::shared_ptr<std::atomic<int>> pendingEdits = std::make_shared<std::atomic<int>>(0);
+    bool isDragging = false;
     bool error = false;
     const String stringArray = "array";
 
@@ -1250,7 +1313,10 @@ public:
         switch(symbol)
         {
             case hash("redraw"): {
-                updateGraphs();
+                // The graphs read the array back on their next frame, so multiple redraws per frame are coalesced
+                for (auto* graph : graphs) {
+                    graph->needsUpdate = true;
+                }
                 if (dialog) {
                     dialog->updateGraphs();
                 }
@@ -202,7 +202,7 @@ public:
 };
 // ELSE keyboard
 class KeyboardObject final : public ObjectBase
-    , public Timer {
+    , public FrameTimer {
 
     Value lowC = SynchronousValue();
     Value octaves = SynchronousValue();
@@ -260,7 +260,7 @@ public:
         objectParameters.addParamReceiveSymbol(&receiveSymbol);
         objectParameters.addParamSendSymbol(&sendSymbol);
 
-        startTimer(150);
+        startFrameTimer(150);
     }
 
     void update() override
@@ -487,7 +487,12 @@ public:
         }
     }
 
-    void timerCallback() override
+    bool isFrameTimerVisible() override
+    {
+        return isVisibleInViewport();
+    }
+
+    void frameTimerCallback() override
     {
         updateValue();
     }
@@ -4,6 +4,7 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
+#include "Utility/SnapshotBuffer.h"
 
 extern "C"
 {
@@ -56,20 +57,141 @@ struct LuaGuiMessage {
     }
 };
 
-class LuaObject : public ObjectBase, public Timer {
+// Compact recording of the draw calls made during a single Lua paint() call
+// It is recorded on the Pd thread and replayed by LuaObject::paint, so draw calls never have to pass through a bounded queue
+struct LuaDisplayList {
+    enum Operation : uint8 {
+        SetColour,
+        StrokeLine,
+        FillEllipse,
+        StrokeEllipse,
+        FillRect,
+        StrokeRect,
+        FillRoundedRect,
+        StrokeRoundedRect,
+        DrawText,
+        StartPath,
+        LineTo,
+        QuadTo,
+        CubicTo,
+        ClosePath,
+        FillPath,
+        StrokePath,
+        FillAll,
+        Translate,
+        Scale,
+        ResetTransform
+    };
+
+    static constexpr int maxArguments = 6;
+
+    struct Command {
+        Operation operation;
+        uint8 numArguments;
+        int textIndex;
+        float arguments[maxArguments];
+    };
+
+    // Vectors are cleared but not freed between frames, so recording doesn't allocate once the list has grown to size
+    std::vector<Command> commands;
+    StringArray texts;
+
+    void clear()
+    {
+        commands.clear();
+        texts.clearQuick();
+    }
+
+    void record(hash32 symbol, int argc, t_atom* argv)
+    {
+        Operation operation;
+        switch (symbol) {
+        case hash("lua_set_color"): operation = SetColour; break;
+        case hash("lua_stroke_line"): operation = StrokeLine; break;
+        case hash("lua_draw_line"): operation = StrokeLine; break;
+        case hash("lua_fill_ellipse"): operation = FillEllipse; break;
+        case hash("lua_stroke_ellipse"): operation = StrokeEllipse; break;
+        case hash("lua_fill_rect"): operation = FillRect; break;
+        case hash("lua_stroke_rect"): operation = StrokeRect; break;
+        case hash("lua_fill_rounded_rect"): operation = FillRoundedRect; break;
+        case hash("lua_stroke_rounded_rect"): operation = StrokeRoundedRect; break;
+        case hash("lua_draw_text"): operation = DrawText; break;
+        case hash("lua_start_path"): operation = StartPath; break;
+        case hash("lua_line_to"): operation = LineTo; break;
+        case hash("lua_quad_to"): operation = QuadTo; break;
+        case hash("lua_cubic_to"): operation = CubicTo; break;
+        case hash("lua_close_path"): operation = ClosePath; break;
+        case hash("lua_fill_path"): operation = FillPath; break;
+        case hash("lua_stroke_path"): operation = StrokePath; break;
+        case hash("lua_fill_all"): operation = FillAll; break;
+        case hash("lua_translate"): operation = Translate; break;
+        case hash("lua_scale"): operation = Scale; break;
+        case hash("lua_reset_transform"): operation = ResetTransform; break;
+        default: return;
+        }
+
+        Command command { operation, 0, -1, {} };
+
+        // The first argument of draw_text is the text itself, the rest are coordinates
+        int firstArgument = 0;
+        if (operation == DrawText && argc > 0) {
+            command.textIndex = texts.size();
+            texts.add(argv[0].a_type == A_SYMBOL ? String::fromUTF8(atom_getsymbol(argv)->s_name) : String(atom_getfloat(argv)));
+            firstArgument = 1;
+        }
+
+        for (int i = firstArgument; i < argc && command.numArguments < maxArguments; i++) {
+            command.arguments[command.numArguments++] = atom_getfloat(argv + i);
+        }
+
+        commands.push_back(command);
+    }
+};
+
+struct LuaPaintStatistics {
+    int commandsLastFrame = 0;
+    float averageCommandsPerFrame = 0.0f;
+    int64 framesReceived = 0;
+    int64 framesDropped = 0; // Frames that Lua painted, but that were replaced before the GUI got to them
+};
+
+class LuaObject : public ObjectBase, public FrameTimer {
+    
+    // Draw calls are recorded into a display list on the Pd thread, and swapped to the GUI when Lua finishes painting
+    SnapshotBuffer<LuaDisplayList> displayLists;
+    LuaDisplayList* recordingList = nullptr;
+    LuaDisplayList const* displayList = nullptr;
+    bool displayListChanged = false;
+    
+    // Only when the display list stays the same between paints, we render it to an image once and reuse that
+    Image cachedImage;
+    float cachedImageScale = 0.0f;
     
-    std::unique_ptr<Graphics> graphics;
-    Colour currentColour;
-    Path currentPath;
-    Image drawBuffer;
-    Image image;
     bool isSelected = false;
-    moodycamel::ReaderWriterQueue<LuaGuiMessage> guiQueue = moodycamel::ReaderWriterQueue<LuaGuiMessage>(40);
+    moodycamel::ReaderWriterQueue<LuaGuiMessage> guiQueue = moodycamel::ReaderWriterQueue<LuaGuiMessage>(8);
     
     std::unique_ptr<Component> textEditor;
     std::unique_ptr<Dialog> saveDialog;
     
+    std::atomic<int64> framesPublished = 0;
+    LuaPaintStatistics statistics;
+    
 public:
+    // The paint statistics are shown below the object description, to help find out why a Lua GUI is slow
+    String getTooltip() override
+    {
+        auto tooltip = SettableTooltipClient::getTooltip();
+        if (statistics.framesReceived == 0)
+            return tooltip;
+        
+        if (tooltip.isNotEmpty())
+            tooltip << "\n\n";
+        
+        tooltip << "Draw commands: " << statistics.commandsLastFrame << " last frame, " << String(statistics.averageCommandsPerFrame, 1) << " on average\n";
+        tooltip << "Frames: " << statistics.framesReceived << " painted, " << statistics.framesDropped << " dropped";
+        return tooltip;
+    }
+    
     LuaObject(pd::WeakReference obj, Object* parent)
     : ObjectBase(obj, parent)
     {
@@ -79,8 +201,7 @@ public:
             pdlua->gfx.plugdata_callback_target = this;
         }
         
-        cnv->zoomScale.addListener(this);
-        startTimerHz(60); // Check for paint messages at 60hz (but we only really repaint when needed)
+        startFrameTimerHz(60); // Check for paint messages at 60hz (but we only really repaint when needed)
     }
     
     ~LuaObject()
@@ -89,7 +210,6 @@ public:
         {
             pdlua->gfx.plugdata_callback_target = NULL;
         }
-        cnv->zoomScale.removeListener(this);
     }
     
     Rectangle<int> getPdBounds() override
@@ -169,288 +289,242 @@ public:
     
     void paint(Graphics& g) override
     {
-        g.drawImage(image, getLocalBounds().toFloat());
+        if (!displayList)
+            return;
+        
+        // While the Lua object is animating, replaying the list directly is cheaper than rendering it into an image first
+        if (displayListChanged) {
+            displayListChanged = false;
+            replayDisplayList(g, *displayList);
+            return;
+        }
+        
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        auto imageWidth = std::max(1, roundToInt(getWidth() * scale));
+        auto imageHeight = std::max(1, roundToInt(getHeight() * scale));
+        if (!cachedImage.isValid() || cachedImageScale != scale || cachedImage.getWidth() != imageWidth || cachedImage.getHeight() != imageHeight) {
+            cachedImage = Image(Image::PixelFormat::ARGB, imageWidth, imageHeight, true);
+            cachedImageScale = scale;
+            
+            Graphics imageGraphics(cachedImage);
+            imageGraphics.addTransform(AffineTransform::scale(scale));
+            replayDisplayList(imageGraphics, *displayList);
+        }
+        
+        g.drawImage(cachedImage, getLocalBounds().toFloat());
     }
     
-    void valueChanged(Value& v) override
+    void lookAndFeelChanged() override
     {
-        if(v.refersToSameSourceAs(cnv->zoomScale))
-        {
-            sendRepaintMessage();
-        }
+        cachedImage = Image();
+        repaint();
     }
     
-    void timerCallback() override
+    void frameTimerCallback() override
     {
         LuaGuiMessage guiMessage;
         while(guiQueue.try_dequeue(guiMessage))
         {
             handleGuiMessage(guiMessage);
         }
+        
+        if(auto const* newList = displayLists.read())
+        {
+            displayList = newList;
+            displayListChanged = true;
+            cachedImage = Image();
+            
+            auto numCommands = static_cast<int>(newList->commands.size());
+            statistics.commandsLastFrame = numCommands;
+            statistics.averageCommandsPerFrame = statistics.framesReceived == 0 ? numCommands : statistics.averageCommandsPerFrame * 0.9f + numCommands * 0.1f;
+            statistics.framesReceived++;
+            statistics.framesDropped = framesPublished.load(std::memory_order_relaxed) - statistics.framesReceived;
+            
+            repaint();
+        }
 
         if(isSelected != object->isSelected())
         {
             isSelected = object->isSelected();
-            sendRepaintMessage();
+            cachedImage = Image();
+            repaint();
         }
     }
     
     void handleGuiMessage(LuaGuiMessage& message)
     {
-        pd::Atom atoms[8];
-        int numAtoms = message.size;
-        for (int at = 0; at < numAtoms; at++) {
-            atoms[at] = pd::Atom(message.data + at);
-        }
-        auto hashsym = hash(message.symbol->s_name);
-        
-        // First check functions that don't need an active graphics context, of modify the active graphics context
-        switch(hashsym)
-        {
-            case hash("lua_start_paint"): {
-                auto scale = getValue<float>(cnv->zoomScale) * 2.0f; // Multiply by 2 for hi-dpi screens
-                drawBuffer = Image(Image::PixelFormat::ARGB, getWidth() * scale, getHeight() * scale, true);
-                graphics = std::make_unique<Graphics>(drawBuffer);
-                graphics->addTransform(AffineTransform::scale(scale)); // for hi-dpi displays
-                graphics->saveState();
-                return;
-            }
-            case hash("lua_end_paint"): {
-                graphics.reset(nullptr);
-                image = drawBuffer.createCopy();
-                repaint();
-                return;
-            }
-            case hash("lua_resized"): {
-                if (numAtoms >= 2) {
-                    if (auto pdlua = ptr.get<t_pdlua>()) {
-                        pdlua->gfx.width = atoms[0].getFloat();
-                        pdlua->gfx.height = atoms[1].getFloat();
-                    }
-                    object->updateBounds();
-                }
-                return;
+        if (hash(message.symbol->s_name) == hash("lua_resized") && message.size >= 2) {
+            if (auto pdlua = ptr.get<t_pdlua>()) {
+                pdlua->gfx.width = atom_getfloat(message.data);
+                pdlua->gfx.height = atom_getfloat(message.data + 1);
             }
+            object->updateBounds();
         }
+    }
+    
+    void replayDisplayList(Graphics& g, LuaDisplayList const& list)
+    {
+        auto colour = Colours::black;
+        Path path;
         
-        if(!graphics) return;
+        g.saveState();
+        g.setColour(colour);
         
-        // Functions that do need an active graphics context
-        switch (hashsym) {
-            case hash("lua_set_color"): {
-                if (numAtoms >= 3) {
-                    Colour color(static_cast<uint8>(atoms[0].getFloat()),
-                                 static_cast<uint8>(atoms[1].getFloat()),
-                                 static_cast<uint8>(atoms[2].getFloat()));
-                    
-                    currentColour = color.withAlpha(numAtoms >= 4 ? atoms[3].getFloat() : 1.0f);
-                    graphics->setColour(currentColour);
+        for (auto const& command : list.commands) {
+            auto const* args = command.arguments;
+            auto numArgs = command.numArguments;
+            
+            switch (command.operation) {
+                case LuaDisplayList::SetColour: {
+                    if (numArgs >= 3) {
+                        colour = Colour(static_cast<uint8>(args[0]), static_cast<uint8>(args[1]), static_cast<uint8>(args[2])).withAlpha(numArgs >= 4 ? args[3] : 1.0f);
+                        g.setColour(colour);
+                    }
+                    break;
                 }
-                break;
-            }
-            case hash("lua_stroke_line"): {
-                if (numAtoms >= 4) {
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
-                    
-                    graphics->drawLine(x1, y1, x2, y2, lineThickness);
+                case LuaDisplayList::StrokeLine: {
+                    if (numArgs >= 5)
+                        g.drawLine(args[0], args[1], args[2], args[3], args[4]);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_fill_ellipse"): {
-                if (numAtoms >= 3) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    graphics->fillEllipse(Rectangle<float>(x, y, w, h));
+                case LuaDisplayList::FillEllipse: {
+                    if (numArgs >= 4)
+                        g.fillEllipse(Rectangle<float>(args[0], args[1], args[2], args[3]));
+                    break;
                 }
-                break;
-            }
-            case hash("lua_stroke_ellipse"): {
-                if (numAtoms >= 4) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
-                    graphics->drawEllipse(Rectangle<float>(x, y, w, h), lineThickness);
+                case LuaDisplayList::StrokeEllipse: {
+                    if (numArgs >= 5)
+                        g.drawEllipse(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4]);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_fill_rect"): {
-                if (numAtoms >= 4) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    graphics->fillRect(Rectangle<float>(x, y, w, h));
+                case LuaDisplayList::FillRect: {
+                    if (numArgs >= 4)
+                        g.fillRect(Rectangle<float>(args[0], args[1], args[2], args[3]));
+                    break;
                 }
-                break;
-            }
-            case hash("lua_stroke_rect"): {
-                if (numAtoms >= 5) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
-                    graphics->drawRect(Rectangle<float>(x, y, w, h), lineThickness);
+                case LuaDisplayList::StrokeRect: {
+                    if (numArgs >= 5)
+                        g.drawRect(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4]);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_fill_rounded_rect"): {
-                if (numAtoms >= 4) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float cornerRadius = atoms[4].getFloat();
-                    graphics->fillRoundedRectangle(Rectangle<float>(x, y, w, h), cornerRadius);
+                case LuaDisplayList::FillRoundedRect: {
+                    if (numArgs >= 5)
+                        g.fillRoundedRectangle(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4]);
+                    break;
                 }
-                break;
-            }
-
-            case hash("lua_stroke_rounded_rect"): {
-                if (numAtoms >= 6) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float cornerRadius = atoms[4].getFloat();
-                    float lineThickness = atoms[5].getFloat();
-                    graphics->drawRoundedRectangle(Rectangle<float>(x, y, w, h), cornerRadius, lineThickness);
+                case LuaDisplayList::StrokeRoundedRect: {
+                    if (numArgs >= 6)
+                        g.drawRoundedRectangle(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4], args[5]);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_draw_line"): {
-                if (numAtoms >= 4) {
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
-                    graphics->drawLine(x1, y1, x2, y2, lineThickness);
+                case LuaDisplayList::DrawText: {
+                    if (numArgs >= 4 && command.textIndex >= 0) {
+                        auto text = AttributedString(list.texts[command.textIndex]);
+                        float w = args[2];
+                        text.setFont(Font(args[3]));
+                        text.setColour(colour);
+                        text.setJustification(Justification::topLeft);
+                        
+                        TextLayout layout;
+                        layout.createLayout(text, w);
+                        layout.draw(g, {args[0], args[1], w, layout.getHeight()});
+                    }
+                    break;
                 }
-                break;
-            }
-            case hash("lua_draw_text"): {
-                if (numAtoms >= 4) {
-                    auto text = AttributedString(atoms[0].toString());
-                    float x = atoms[1].getFloat();
-                    float y = atoms[2].getFloat();
-                    float w = atoms[3].getFloat();
-                    float fontHeight = atoms[4].getFloat();
-                    
-                    text.setFont(Font(fontHeight));
-                    text.setColour(currentColour);
-                    text.setJustification(Justification::topLeft);
-                    
-                    TextLayout layout;
-                    layout.createLayout(text, w);
-                    layout.draw(*graphics, {x, y, w, layout.getHeight()});
+                case LuaDisplayList::StartPath: {
+                    if (numArgs >= 2) {
+                        path = Path();
+                        path.startNewSubPath(args[0], args[1]);
+                    }
+                    break;
                 }
-                break;
-            }
-            case hash("lua_start_path"): {
-                if (numAtoms >= 2) {
-                    currentPath = Path();
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    currentPath.startNewSubPath(x, y);
+                case LuaDisplayList::LineTo: {
+                    if (numArgs >= 2)
+                        path.lineTo(args[0], args[1]);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_line_to"): {
-                if (numAtoms >= 2) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    currentPath.lineTo(x, y);
+                case LuaDisplayList::QuadTo: {
+                    if (numArgs >= 4)
+                        path.quadraticTo(args[0], args[1], args[2], args[3]);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_quad_to"): {
-                if (numAtoms >= 4) { // Assuming quad_to takes 3 arguments
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    currentPath.quadraticTo(x1, y1, x2, y2);
+                case LuaDisplayList::CubicTo: {
+                    if (numArgs >= 6)
+                        path.cubicTo(args[0], args[1], args[2], args[3], args[4], args[5]);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_cubic_to"): {
-                if (numAtoms >= 6) { // Assuming cubic_to takes 4 arguments
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    float x3 = atoms[4].getFloat();
-                    float y3 = atoms[5].getFloat();
-                    currentPath.cubicTo(x1, y1, x2, y2, x3, y3);
+                case LuaDisplayList::ClosePath: {
+                    path.closeSubPath();
+                    break;
                 }
-                break;
-            }
-            case hash("lua_close_path"): {
-                currentPath.closeSubPath();
-                break;
-            }
-            case hash("lua_fill_path"): {
-                graphics->fillPath(currentPath);
-                break;
-            }
-            case hash("lua_stroke_path"): {
-                if (numAtoms >= 1) {
-                    graphics->strokePath(currentPath, PathStrokeType(atoms[0].getFloat()));
+                case LuaDisplayList::FillPath: {
+                    g.fillPath(path);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_fill_all"): {
-                auto colour = currentColour;
-                
-                graphics->fillRoundedRectangle(getLocalBounds().toFloat(), Corners::objectCornerRadius);
-                
-                auto outlineColour = object->findColour(isSelected ? PlugDataColour::objectSelectedOutlineColourId : objectOutlineColourId);
-                graphics->setColour(outlineColour);
-                graphics->drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
-                
-                graphics->setColour(colour);
-                
-                break;
-            }
-                
-            case hash("lua_translate"): {
-                if (numAtoms >= 2) {
-                    float tx = atoms[0].getFloat();
-                    float ty = atoms[1].getFloat();
-                    graphics->addTransform(AffineTransform::translation(tx, ty));
+                case LuaDisplayList::StrokePath: {
+                    if (numArgs >= 1)
+                        g.strokePath(path, PathStrokeType(args[0]));
+                    break;
                 }
-                break;
-            }
-            case hash("lua_scale"): {
-                if (numAtoms >= 2) {
-                    float sx = atoms[0].getFloat();
-                    float sy = atoms[1].getFloat();
-                    graphics->addTransform(AffineTransform::scale(sx, sy));
+                case LuaDisplayList::FillAll: {
+                    g.fillRoundedRectangle(getLocalBounds().toFloat(), Corners::objectCornerRadius);
+                    
+                    auto outlineColour = object->findColour(isSelected ? PlugDataColour::objectSelectedOutlineColourId : objectOutlineColourId);
+                    g.setColour(outlineColour);
+                    g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
+                    g.setColour(colour);
+                    break;
+                }
+                case LuaDisplayList::Translate: {
+                    if (numArgs >= 2)
+                        g.addTransform(AffineTransform::translation(args[0], args[1]));
+                    break;
+                }
+                case LuaDisplayList::Scale: {
+                    if (numArgs >= 2)
+                        g.addTransform(AffineTransform::scale(args[0], args[1]));
+                    break;
+                }
+                case LuaDisplayList::ResetTransform: {
+                    g.restoreState();
+                    g.saveState();
+                    g.setColour(colour);
+                    break;
                 }
-                break;
-            }
-            case hash("lua_reset_transform"): {
-                graphics->restoreState();
-                graphics->saveState();
-                break;
             }
-            default:
-                break;
         }
+        
+        g.restoreState();
     }
     
+    // Called on the Pd thread while Lua is painting
     void receiveLuaPaintMessage(t_symbol* sym, int argc, t_atom* argv)
     {
-        guiQueue.enqueue({sym, argc, argv});
+        auto symbol = hash(sym->s_name);
+        switch (symbol) {
+            case hash("lua_start_paint"): {
+                recordingList = &displayLists.beginWrite();
+                recordingList->clear();
+                return;
+            }
+            case hash("lua_end_paint"): {
+                if (recordingList) {
+                    displayLists.endWrite();
+                    recordingList = nullptr;
+                    framesPublished.fetch_add(1, std::memory_order_relaxed);
+                }
+                return;
+            }
+            case hash("lua_resized"): {
+                guiQueue.enqueue({sym, argc, argv});
+                return;
+            }
+            default:
+                break;
+        }
+        
+        if (recordingList)
+            recordingList->record(symbol, argc, argv);
     }
     
     static void drawCallback(void* target, t_symbol* sym, int argc, t_atom* argv)
@@ -7,7 +7,7 @@
 #include "Components/DraggableNumber.h"
 
 class NumboxTildeObject final : public ObjectBase
-    , public Timer {
+    , public FrameTimer {
 
     DraggableNumber input;
 
@@ -53,7 +53,7 @@ public:
             }
         };
 
-        startTimer(nextInterval);
+        startFrameTimer(nextInterval);
         repaint();
 
         objectParameters.addParamSize(&sizeProperty);
@@ -262,7 +262,12 @@ public:
         g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
     }
 
-    void timerCallback() override
+    bool isFrameTimerVisible() override
+    {
+        return isVisibleInViewport();
+    }
+
+    void frameTimerCallback() override
     {
         auto val = getValue();
 
@@ -270,7 +275,7 @@ public:
             input.setText(input.formatNumber(val), dontSendNotification);
         }
 
-        startTimer(nextInterval);
+        startFrameTimer(nextInterval);
     }
 
     float getValue()
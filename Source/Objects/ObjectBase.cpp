@@ -740,6 +740,19 @@ bool ObjectBase::isBeingEdited()
     return edited;
 }
 
+bool ObjectBase::isVisibleInViewport()
+{
+    if (!isShowing())
+        return false;
+
+    // Objects inside a graph don't have their own viewport
+    if (!cnv->viewport)
+        return true;
+
+    auto viewArea = cnv->viewport->getViewArea().transformedBy(cnv->getTransform().inverted());
+    return viewArea.intersects(object->getBounds());
+}
+
 ComponentBoundsConstrainer* ObjectBase::getConstrainer()
 {
     return constrainer.get();
@@ -11,6 +11,7 @@
 #include "Constants.h"
 #include "ObjectParameters.h"
 #include "Utility/SynchronousValue.h"
+#include "Utility/FrameScheduler.h"
 
 class PluginProcessor;
 class Canvas;
@@ -163,6 +164,10 @@ public:
     // Global flag to find out if any GUI object is currently being interacted with
     static bool isBeingEdited();
 
+    // Returns true if the object is showing and inside the visible area of its canvas
+    // Used to skip periodic updates for objects that can't be seen
+    bool isVisibleInViewport();
+
     ComponentBoundsConstrainer* getConstrainer();
 
     ObjectParameters objectParameters;
@@ -471,7 +471,7 @@ public:
 
 class CanvasVisibleObject final : public ImplementationBase
     , public ComponentListener
-    , public Timer {
+    , public FrameTimer {
 
     bool lastFocus = false;
     Component::SafePointer<Canvas> cnv;
@@ -495,7 +495,7 @@ public:
             return;
 
         cnv->addComponentListener(this);
-        startTimer(100);
+        startFrameTimer(100);
     }
 
     void updateVisibility()
@@ -529,7 +529,7 @@ public:
         updateVisibility();
     }
 
-    void timerCallback() override
+    void frameTimerCallback() override
     {
         updateVisibility();
     }
@@ -582,7 +582,7 @@ public:
 
 // Else "mouse" component
 class MouseObject final : public ImplementationBase
-    , public Timer {
+    , public FrameTimer {
 
 public:
     MouseObject(t_gobj* ptr, t_canvas* parent, PluginProcessor* pd)
@@ -591,11 +591,11 @@ public:
     {
         lastPosition = mouseSource.getScreenPosition();
         lastMouseDownTime = mouseSource.getLastMouseDownTime();
-        startTimer(timerInterval);
+        startFrameTimer(timerInterval);
         canvas = this->ptr.get<t_fake_mouse>()->x_glist;
     }
 
-    void timerCallback() override
+    void frameTimerCallback() override
     {
         if (pd->isPerformingGlobalSync)
             return;
@@ -4,9 +4,25 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
+#include "Utility/SnapshotBuffer.h"
+
 template<typename S>
 class ScopeBase : public ObjectBase
-    , public Timer {
+    , public FrameTimer
+    , public pd::SnapshotSource {
+
+    struct ScopeSnapshot {
+        float x[SCOPE_MAXBUFSIZE * 4];
+        float y[SCOPE_MAXBUFSIZE * 4];
+        int bufsize = 0;
+        int mode = 0;
+        float min = 0.0f;
+        float max = 1.0f;
+    };
+
+    // Written by the audio thread, read by the GUI without taking the Pd lock
+    SnapshotBuffer<ScopeSnapshot> snapshots;
+    std::atomic<bool> snapshotRequested = true;
 
     std::vector<float> x_buffer;
     std::vector<float> y_buffer;
@@ -41,7 +57,13 @@ public:
 
         objectParameters.addParamReceiveSymbol(&receiveSymbol);
 
-        startTimerHz(25);
+        pd->registerSnapshotSource(this);
+        startFrameTimerHz(25);
+    }
+
+    ~ScopeBase() override
+    {
+        pd->unregisterSnapshotSource(this);
     }
 
     void updateSizeProperty() override
@@ -159,66 +181,120 @@ public:
         g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
     }
 
-    void timerCallback() override
+    bool isFrameTimerVisible() override
     {
-        int bufsize = 0, mode = 0;
-        float min = 0.0f, max = 1.0f;
+        return isVisibleInViewport();
+    }
+
+    void publishSnapshot() override
+    {
+        // Only copy the buffers once the GUI has picked up the previous snapshot
+        if (!snapshotRequested.exchange(false))
+            return;
+
+        if (auto* scope = ptr.getRaw<S>()) {
+            auto& snapshot = snapshots.beginWrite();
+            snapshot.bufsize = std::clamp<int>(scope->x_bufsize, 0, SCOPE_MAXBUFSIZE * 4);
+            snapshot.mode = scope->x_xymode;
+            snapshot.min = scope->x_min;
+            snapshot.max = scope->x_max;
+
+            std::copy(scope->x_xbuflast, scope->x_xbuflast + snapshot.bufsize, snapshot.x);
+            std::copy(scope->x_ybuflast, scope->x_ybuflast + snapshot.bufsize, snapshot.y);
+            snapshots.endWrite();
+        }
+    }
 
+    void frameTimerCallback() override
+    {
         if (object->iolets.size() == 3)
             object->iolets[2]->setVisible(false);
 
-        if (auto scope = ptr.get<S>()) {
-            bufsize = scope->x_bufsize;
-            min = scope->x_min;
-            max = scope->x_max;
-            mode = scope->x_xymode;
-
-            if (x_buffer.size() != bufsize) {
-                x_buffer.resize(bufsize);
-                y_buffer.resize(bufsize);
-            }
+        auto const* snapshot = snapshots.read();
+        snapshotRequested = true;
 
-            std::copy(scope->x_xbuflast, scope->x_xbuflast + bufsize, x_buffer.data());
-            std::copy(scope->x_ybuflast, scope->x_ybuflast + bufsize, y_buffer.data());
-        }
+        if (!snapshot)
+            return;
+
+        auto const bufsize = snapshot->bufsize;
+        auto min = snapshot->min;
+        auto max = snapshot->max;
 
         if (min > max) {
-            auto temp = max;
-            max = min;
-            min = temp;
+            std::swap(min, max);
         }
 
-        float oldx = 0, oldy = 0;
-        float dx = (getWidth() - 2) / (float)bufsize;
-        float dy = (getHeight() - 2) / (float)bufsize;
-
         float waveAreaHeight = getHeight() - 2;
         float waveAreaWidth = getWidth() - 2;
 
-        for (int n = 0; n < bufsize; n++) {
-            switch (mode) {
-            case 1:
-                y_buffer[n] = jmap<float>(x_buffer[n], min, max, waveAreaHeight, 2.f);
-                x_buffer[n] = oldx;
-                oldx += dx;
-                break;
-            case 2:
-                x_buffer[n] = jmap<float>(y_buffer[n], min, max, 2.f, waveAreaWidth);
-                y_buffer[n] = oldy;
-                oldy += dy;
-                break;
-            case 3:
-                x_buffer[n] = jmap<float>(x_buffer[n], min, max, 2.f, waveAreaWidth);
-                y_buffer[n] = jmap<float>(y_buffer[n], min, max, waveAreaHeight, 2.f);
-                break;
-            default:
-                break;
-            }
+        switch (snapshot->mode) {
+        case 1:
+            decimate(snapshot->x, bufsize, waveAreaWidth, x_buffer, y_buffer);
+            mapToPixels(y_buffer, min, max, waveAreaHeight, 2.f);
+            break;
+        case 2:
+            decimate(snapshot->y, bufsize, waveAreaHeight, y_buffer, x_buffer);
+            mapToPixels(x_buffer, min, max, 2.f, waveAreaWidth);
+            break;
+        case 3:
+            x_buffer.assign(snapshot->x, snapshot->x + bufsize);
+            y_buffer.assign(snapshot->y, snapshot->y + bufsize);
+            mapToPixels(x_buffer, min, max, 2.f, waveAreaWidth);
+            mapToPixels(y_buffer, min, max, waveAreaHeight, 2.f);
+            break;
+        default:
+            x_buffer.assign(snapshot->x, snapshot->x + bufsize);
+            y_buffer.assign(snapshot->y, snapshot->y + bufsize);
+            break;
         }
 
         repaint();
     }
 
+    // Spreads the samples out over the time axis
+    // When there are more samples than pixels, we only keep the minimum and maximum per pixel, so peaks stay visible
+    static void decimate(float const* samples, int numSamples, float length, std::vector<float>& positions, std::vector<float>& values)
+    {
+        auto const numPixels = static_cast<int>(length);
+
+        if (numPixels <= 0 || numSamples <= numPixels * 2) {
+            auto const delta = length / static_cast<float>(std::max(numSamples, 1));
+            positions.resize(numSamples);
+            values.assign(samples, samples + numSamples);
+            for (int n = 0; n < numSamples; n++) {
+                positions[n] = n * delta;
+            }
+            return;
+        }
+
+        positions.resize(numPixels * 2);
+        values.resize(numPixels * 2);
+        for (int px = 0; px < numPixels; px++) {
+            auto const start = px * numSamples / numPixels;
+            auto const end = (px + 1) * numSamples / numPixels;
+            auto const range = FloatVectorOperations::findMinAndMax(samples + start, end - start);
+
+            positions[px * 2] = positions[px * 2 + 1] = static_cast<float>(px);
+            values[px * 2] = range.getStart();
+            values[px * 2 + 1] = range.getEnd();
+        }
+    }
+
+    // Maps signal values to pixel coordinates, equivalent to calling jmap on every value, but vectorised
+    static void mapToPixels(std::vector<float>& values, float min, float max, float targetMin, float targetMax)
+    {
+        auto const numValues = static_cast<int>(values.size());
+
+        if (approximatelyEqual(min, max)) {
+            FloatVectorOperations::fill(values.data(), targetMin, numValues);
+            return;
+        }
+
+        auto const scale = (targetMax - targetMin) / (max - min);
+        FloatVectorOperations::multiply(values.data(), scale, numValues);
+        FloatVectorOperations::add(values.data(), targetMin - min * scale, numValues);
+    }
+
     void valueChanged(Value& v) override
     {
 
@@ -0,0 +1,73 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "Utility/Config.h"
+
+extern "C" {
+#include <m_pd.h>
+#include <g_canvas.h>
+}
+
+#include "AbstractionGraph.h"
+
+namespace pd {
+
+void AbstractionGraph::rebuild()
+{
+    instances.clear();
+
+    for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
+        addChildren(x);
+    }
+}
+
+void AbstractionGraph::addChildren(t_canvas* cnv)
+{
+    for (auto* y = cnv->gl_list; y; y = y->g_next) {
+        if (pd_class(&y->g_pd) != canvas_class)
+            continue;
+
+        auto* child = reinterpret_cast<t_canvas*>(y);
+        if (canvas_isabstraction(child)) {
+            // Same way canvas_reload identifies the file of an abstraction
+            auto path = String::fromUTF8(canvas_getdir(child)->s_name) + "/" + String::fromUTF8(child->gl_name->s_name);
+            instances[File(path).getFullPathName()].push_back(child);
+        }
+
+        addChildren(child);
+    }
+}
+
+std::vector<t_canvas*> AbstractionGraph::getInstances(File const& file, t_glist* except) const
+{
+    auto it = instances.find(file.getFullPathName());
+    if (it == instances.end())
+        return {};
+
+    std::vector<t_canvas*> result;
+    for (auto* instance : it->second) {
+        if (instance != except)
+            result.push_back(instance);
+    }
+
+    return result;
+}
+
+std::set<t_canvas*> AbstractionGraph::getDependentCanvases(File const& file, t_glist* except) const
+{
+    std::set<t_canvas*> result;
+    for (auto* instance : getInstances(file, except)) {
+        for (auto* cnv = instance; cnv; cnv = cnv->gl_owner) {
+            // Everything above was already added by another instance
+            if (!result.insert(cnv).second)
+                break;
+        }
+    }
+
+    return result;
+}
+
+} // namespace pd
@@ -0,0 +1,38 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include "Utility/Config.h"
+
+extern "C" {
+#include "Pd/Interface.h"
+}
+
+namespace pd {
+
+// Which canvases instantiate which abstraction files
+// Used to only reload and resynchronise the parts of the open patches that depend on a changed file
+class AbstractionGraph {
+public:
+    // Walks all patches of the current Pd instance, the caller needs to hold the Pd lock
+    void rebuild();
+
+    // Instances of the file, except for the canvas it was saved from
+    std::vector<t_canvas*> getInstances(File const& file, t_glist* except = nullptr) const;
+
+    // The instances of the file, and every canvas that contains one of them, directly or through subpatches and other abstractions
+    std::set<t_canvas*> getDependentCanvases(File const& file, t_glist* except = nullptr) const;
+
+private:
+    void addChildren(t_canvas* cnv);
+
+    std::map<String, std::vector<t_canvas*>> instances;
+};
+
+} // namespace pd
@@ -0,0 +1,276 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "Utility/Config.h"
+
+#include <BinaryData.h>
+
+#include "DocumentationIndex.h"
+
+namespace pd {
+
+namespace {
+float const nameWeight = 8.0f;
+float const descriptionWeight = 3.0f;
+float const categoryWeight = 2.0f;
+float const detailWeight = 1.0f;
+
+// Matching only the start of a term is worth less than matching all of it
+float const prefixMatchFactor = 0.6f;
+
+uint32 const headerSize = 12;
+uint32 const tableEntrySize = 16;
+}
+
+DocumentationIndex::DocumentationIndex()
+    : data(BinaryData::Documentation_bin)
+    , dataSize(static_cast<size_t>(BinaryData::Documentation_binSize))
+{
+    // Only the header is read here, everything else is decoded when it's needed
+    if (dataSize < headerSize || std::string_view(data, 4) != "PDDX" || ByteOrder::littleEndianInt(data + 4) != 1) {
+        jassertfalse; // Documentation.bin is outdated, rerun parse_documentation.py
+        return;
+    }
+
+    auto count = ByteOrder::littleEndianInt(data + 8);
+    if (headerSize + static_cast<size_t>(count) * tableEntrySize > dataSize)
+        return;
+
+    numObjects = static_cast<int>(count);
+}
+
+DocumentationIndex::~DocumentationIndex()
+{
+    clearSingletonInstance();
+}
+
+DocumentationIndex::TableEntry DocumentationIndex::getTableEntry(int index) const
+{
+    auto const* entry = data + headerSize + static_cast<size_t>(index) * tableEntrySize;
+    return { ByteOrder::littleEndianInt(entry), ByteOrder::littleEndianInt(entry + 4), ByteOrder::littleEndianInt(entry + 8), ByteOrder::littleEndianInt(entry + 12) };
+}
+
+std::string_view DocumentationIndex::getNameData(int index) const
+{
+    auto entry = getTableEntry(index);
+    if (static_cast<size_t>(entry.nameOffset) + entry.nameLength > dataSize)
+        return {};
+
+    return { data + entry.nameOffset, entry.nameLength };
+}
+
+String DocumentationIndex::getObjectName(int index) const
+{
+    auto name = getNameData(index);
+    return String::fromUTF8(name.data(), static_cast<int>(name.size()));
+}
+
+int DocumentationIndex::findObject(String const& name) const
+{
+    // The table is sorted by the UTF-8 bytes of the names
+    auto utf8 = name.toRawUTF8();
+    auto target = std::string_view(utf8, name.getNumBytesAsUTF8());
+
+    int low = 0;
+    int high = numObjects;
+    while (low < high) {
+        auto mid = low + (high - low) / 2;
+        if (getNameData(mid) < target)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low < numObjects && getNameData(low) == target ? low : -1;
+}
+
+ValueTree DocumentationIndex::getObjectInfo(String const& name) const
+{
+    auto index = findObject(name);
+    return index >= 0 ? getObjectInfo(index) : ValueTree();
+}
+
+ValueTree DocumentationIndex::getObjectInfo(int index) const
+{
+    if (!isPositiveAndBelow(index, numObjects))
+        return {};
+
+    auto entry = getTableEntry(index);
+    if (static_cast<size_t>(entry.entryOffset) + entry.entryLength > dataSize)
+        return {};
+
+    return ValueTree::readFromData(data + entry.entryOffset, entry.entryLength);
+}
+
+StringArray DocumentationIndex::getAllCategories()
+{
+    std::call_once(searchIndexFlag, [this]() { buildSearchIndex(); });
+    return allCategories;
+}
+
+void DocumentationIndex::buildSearchIndex()
+{
+    std::unordered_map<String, std::vector<Posting>> termPostings;
+
+    for (int object = 0; object < numObjects; object++) {
+        // Decoded objects are only kept around while we tokenize them
+        auto info = getObjectInfo(object);
+        auto name = getObjectName(object);
+
+        std::unordered_map<String, float> objectTerms;
+        addTerms(objectTerms, name, nameWeight);
+        addTerms(objectTerms, info.getProperty("description").toString(), descriptionWeight);
+
+        for (auto category : info.getChildWithName("categories")) {
+            auto categoryName = category.getProperty("name").toString();
+            allCategories.addIfNotAlreadyThere(categoryName);
+            addTerms(objectTerms, categoryName, categoryWeight);
+        }
+        for (auto argument : info.getChildWithName("arguments")) {
+            addTerms(objectTerms, argument.getProperty("description").toString(), detailWeight);
+        }
+        for (auto method : info.getChildWithName("methods")) {
+            addTerms(objectTerms, method.getProperty("type").toString(), detailWeight);
+            addTerms(objectTerms, method.getProperty("description").toString(), detailWeight);
+        }
+        for (auto flag : info.getChildWithName("flags")) {
+            addTerms(objectTerms, flag.getProperty("description").toString(), detailWeight);
+        }
+        for (auto iolet : info.getChildWithName("iolets")) {
+            for (auto message : iolet) {
+                addTerms(objectTerms, message.getProperty("description").toString(), detailWeight);
+            }
+        }
+
+        for (auto const& [term, weight] : objectTerms) {
+            termPostings[term].push_back({ object, weight });
+        }
+    }
+
+    terms.reserve(termPostings.size());
+    for (auto const& [term, termPosting] : termPostings) {
+        terms.push_back(term);
+    }
+    std::sort(terms.begin(), terms.end());
+
+    // Bake the inverse document frequency into the weights, so rare terms count for more
+    postings.reserve(terms.size());
+    for (auto const& term : terms) {
+        auto& termPosting = termPostings[term];
+        auto idf = std::log(1.0f + static_cast<float>(numObjects) / static_cast<float>(termPosting.size()));
+        for (auto& posting : termPosting) {
+            posting.weight *= idf;
+        }
+        postings.push_back(std::move(termPosting));
+    }
+}
+
+StringArray DocumentationIndex::tokenize(String const& text)
+{
+    StringArray tokens;
+    String token;
+
+    for (auto character : text.toLowerCase()) {
+        // Keep the tilde, so signal objects can be told apart from their control counterparts
+        if (CharacterFunctions::isLetterOrDigit(character) || character == '~') {
+            token += character;
+        } else if (token.isNotEmpty()) {
+            tokens.add(token);
+            token.clear();
+        }
+    }
+
+    if (token.isNotEmpty())
+        tokens.add(token);
+
+    return tokens;
+}
+
+void DocumentationIndex::addTerms(std::unordered_map<String, float>& objectTerms, String const& text, float weight) const
+{
+    for (auto const& token : tokenize(text)) {
+        auto& termWeight = objectTerms[token];
+        termWeight = std::max(termWeight, weight);
+    }
+}
+
+std::vector<DocumentationIndex::Result> DocumentationIndex::search(String const& query, int maxResults)
+{
+    std::call_once(searchIndexFlag, [this]() { buildSearchIndex(); });
+
+    auto queryTerms = tokenize(query);
+    queryTerms.removeDuplicates(false);
+
+    if (queryTerms.isEmpty())
+        return {};
+
+    std::unordered_map<int, float> scores;
+    bool isFirstTerm = true;
+
+    for (auto const& queryTerm : queryTerms) {
+        // Best match of this query term for each object
+        std::unordered_map<int, float> termScores;
+
+        auto it = std::lower_bound(terms.begin(), terms.end(), queryTerm);
+        for (; it != terms.end() && it->startsWith(queryTerm); ++it) {
+            auto factor = *it == queryTerm ? 1.0f : prefixMatchFactor;
+            for (auto const& posting : postings[std::distance(terms.begin(), it)]) {
+                auto& score = termScores[posting.object];
+                score = std::max(score, posting.weight * factor);
+            }
+        }
+
+        // Objects have to match all terms
+        if (isFirstTerm) {
+            scores = std::move(termScores);
+            isFirstTerm = false;
+        } else {
+            std::unordered_map<int, float> intersection;
+            for (auto const& [object, score] : scores) {
+                if (auto match = termScores.find(object); match != termScores.end())
+                    intersection[object] = score + match->second;
+            }
+            scores = std::move(intersection);
+        }
+
+        if (scores.empty())
+            return {};
+    }
+
+    auto trimmedQuery = query.trim();
+
+    std::vector<Result> results;
+    results.reserve(scores.size());
+    for (auto const& [object, score] : scores) {
+        auto name = getObjectName(object);
+
+        auto total = score;
+        if (name.equalsIgnoreCase(trimmedQuery))
+            total += 100.0f;
+        else if (name.startsWithIgnoreCase(trimmedQuery))
+            total += 20.0f;
+
+        results.push_back({ name, total });
+    }
+
+    auto numResults = maxResults >= 0 ? std::min<size_t>(maxResults, results.size()) : results.size();
+    auto isRankedHigher = [](Result const& a, Result const& b) {
+        if (a.score != b.score)
+            return a.score > b.score;
+        return a.name < b.name;
+    };
+
+    std::partial_sort(results.begin(), results.begin() + numResults, results.end(), isRankedHigher);
+    results.resize(numResults);
+
+    return results;
+}
+
+JUCE_IMPLEMENT_SINGLETON(DocumentationIndex)
+
+} // namespace pd
@@ -0,0 +1,81 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include "Utility/Config.h"
+
+namespace pd {
+
+// Documentation for all objects, shared by all plugin instances
+// Documentation.bin is generated by parse_documentation.py. It starts with a table of offsets sorted by object name,
+// followed by every object encoded separately in ValueTree binary format. We read it straight from the binary data that
+// the OS maps in with the plugin, and only decode an object when it's asked for.
+// The inverted index for searching is built on the first search, after that it's never modified, so it can be searched
+// from any thread without locking
+class DocumentationIndex : public DeletedAtShutdown {
+public:
+    struct Result {
+        String name;
+        float score;
+    };
+
+    DocumentationIndex();
+    ~DocumentationIndex() override;
+
+    int getNumObjects() const { return numObjects; }
+    String getObjectName(int index) const;
+
+    // Returns an invalid tree if the object has no documentation
+    ValueTree getObjectInfo(String const& name) const;
+    ValueTree getObjectInfo(int index) const;
+
+    StringArray getAllCategories();
+
+    // Ranked search, every term in the query has to match the start of a word in the object's name or documentation
+    // Matches in the name score higher than matches in the description, which score higher than arguments, iolets and methods
+    std::vector<Result> search(String const& query, int maxResults = -1);
+
+    static StringArray tokenize(String const& text);
+
+    JUCE_DECLARE_SINGLETON(DocumentationIndex, false)
+
+private:
+    struct Posting {
+        int object;
+        float weight;
+    };
+
+    struct TableEntry {
+        uint32 nameOffset;
+        uint32 nameLength;
+        uint32 entryOffset;
+        uint32 entryLength;
+    };
+
+    TableEntry getTableEntry(int index) const;
+    std::string_view getNameData(int index) const;
+    int findObject(String const& name) const;
+
+    void buildSearchIndex();
+    void addTerms(std::unordered_map<String, float>& terms, String const& text, float weight) const;
+
+    char const* data = nullptr;
+    size_t dataSize = 0;
+    int numObjects = 0;
+
+    std::once_flag searchIndexFlag;
+    StringArray allCategories;
+
+    // Terms are sorted, so prefix queries are a binary search
+    std::vector<String> terms;
+    std::vector<std::vector<Posting>> postings;
+};
+
+} // namespace pd
@@ -342,7 +342,17 @@ void Instance::releaseDSP()
 void Instance::performDSP(float const* inputs, float* outputs)
 {
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
+
+    // libpd takes the Pd lock for the tick anyway, so this doesn't add any waiting. Holding it until the taps are done
+    // keeps the signal vectors alive until they've been read. The lock is recursive
+    lockAudioThread();
     libpd_process_raw(inputs, outputs);
+
+    for (auto* tap : signalTaps) {
+        tap->tapSignals();
+    }
+
+    unlockAudioThread();
 }
 
 void Instance::sendNoteOn(int const channel, int const pitch, int const velocity) const
@@ -523,6 +533,47 @@ void Instance::unregisterMessageListener(void* object, MessageListener* messageL
     messageDispatcher->removeMessageListener(object, messageListener);
 }
 
+void Instance::registerSnapshotSource(SnapshotSource* source)
+{
+    lockAudioThread();
+    snapshotSources.addIfNotAlreadyThere(source);
+    unlockAudioThread();
+}
+
+void Instance::unregisterSnapshotSource(SnapshotSource* source)
+{
+    lockAudioThread();
+    snapshotSources.removeFirstMatchingValue(source);
+    unlockAudioThread();
+}
+
+void Instance::registerSignalTap(SignalTap* tap)
+{
+    lockAudioThread();
+    signalTaps.addIfNotAlreadyThere(tap);
+    unlockAudioThread();
+}
+
+void Instance::unregisterSignalTap(SignalTap* tap)
+{
+    lockAudioThread();
+    signalTaps.removeFirstMatchingValue(tap);
+    unlockAudioThread();
+}
+
+void Instance::publishSnapshots()
+{
+    // Never make the audio thread wait for the message thread: if the lock is taken, we'll publish on the next tick
+    if (!tryLockAudioThread())
+        return;
+
+    for (auto* source : snapshotSources) {
+        source->publishSnapshot();
+    }
+
+    unlockAudioThread();
+}
+
 void Instance::registerWeakReference(void* ptr, pd_weak_reference* ref)
 {
     weakReferenceMutex.lock();
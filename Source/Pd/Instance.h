@@ -135,6 +135,26 @@ private:
 class MessageListener;
 class MessageDispatcher;
 class Patch;
+
+// Interface for GUI objects that need a copy of Pd's internal state from the audio thread
+// This allows the GUI to read the data without ever taking the Pd lock
+class SnapshotSource {
+public:
+    virtual ~SnapshotSource() = default;
+
+    // Called on the audio thread after each DSP tick, while holding the Pd lock
+    virtual void publishSnapshot() = 0;
+};
+
+// Interface for readers of signal data that need every DSP tick
+// Unlike snapshot sources, taps are never skipped when the message thread holds the Pd lock
+class SignalTap {
+public:
+    virtual ~SignalTap() = default;
+
+    // Called on the audio thread right after each DSP tick, still inside the Pd lock the tick ran under
+    virtual void tapSignals() = 0;
+};
 class Instance {
     struct Message {
         String selector;
@@ -222,6 +242,13 @@ public:
     void registerMessageListener(void* object, MessageListener* messageListener);
     void unregisterMessageListener(void* object, MessageListener* messageListener);
 
+    void registerSnapshotSource(SnapshotSource* source);
+    void unregisterSnapshotSource(SnapshotSource* source);
+    void publishSnapshots();
+
+    void registerSignalTap(SignalTap* tap);
+    void unregisterSignalTap(SignalTap* tap);
+
     void registerWeakReference(void* ptr, pd_weak_reference* ref);
     void unregisterWeakReference(void* ptr, pd_weak_reference const* ref);
     void clearWeakReferences(void* ptr);
@@ -319,6 +346,9 @@ private:
 
     std::unique_ptr<ObjectImplementationManager> objectImplementations;
 
+    Array<SnapshotSource*> snapshotSources;
+    Array<SignalTap*> signalTaps;
+
     moodycamel::ConcurrentQueue<std::function<void(void)>> functionQueue = moodycamel::ConcurrentQueue<std::function<void(void)>>(4096);
 
     std::unique_ptr<FileChooser> openChooser;
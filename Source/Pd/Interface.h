@@ -437,6 +437,13 @@ struct Interface {
         return count;
     }
 
+    // Identifies the current position in the undo queue
+    static void* getLastUndoAction(t_canvas* cnv)
+    {
+        t_undo* udo = canvas_undo_get(cnv);
+        return udo ? udo->u_last : nullptr;
+    }
+
     static int canUndo(t_canvas* cnv)
     {
         t_undo* udo = canvas_undo_get(cnv);
@@ -521,6 +528,15 @@ struct Interface {
     }
 
     static void getCanvasContent(t_canvas* cnv, char** buf, int* bufsize)
+    {
+        t_binbuf* b = getCanvasBinbuf(cnv);
+        binbuf_gettext(b, buf, bufsize);
+        binbuf_free(b);
+    }
+
+    // Copies the canvas into a new binbuf, the caller is responsible for freeing it
+    // Only building the binbuf needs the Pd lock, converting it to text doesn't
+    static t_binbuf* getCanvasBinbuf(t_canvas* cnv)
     {
         t_binbuf* b = binbuf_new();
 
@@ -591,8 +607,7 @@ struct Interface {
                     (t_float)cnv->gl_isgraph);
         }
 
-        binbuf_gettext(b, buf, bufsize);
-        binbuf_free(b);
+        return b;
     }
 
     static int numOutlets(t_object const* x)
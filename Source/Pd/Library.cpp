@@ -10,9 +10,9 @@
 
 #include "Utility/Config.h"
 
-#include <BinaryData.h>
-
 #include "Utility/OSUtils.h"
+#include "Utility/FilesystemExtractor.h"
+#include "Utility/StartupTrace.h"
 
 extern "C" {
 #include <m_pd.h>
@@ -23,7 +23,9 @@ extern "C" {
 }
 
 #include <utility>
+#include <unordered_set>
 #include "Library.h"
+#include "DocumentationIndex.h"
 #include "Instance.h"
 #include "Pd/Interface.h"
 
@@ -39,92 +41,103 @@ namespace pd {
 
 void Library::updateLibrary()
 {
-    auto settingsTree = ValueTree::fromXml(ProjectInfo::appDataDir.getChildFile(".settings").loadFileAsString());
-    auto pathTree = settingsTree.getChildWithName("Paths");
-
-    sys_lock();
+    StartupTrace::ScopedPhase tracePhase("Update object library");
 
     // Get available objects directly from pd
-    t_class* o = pd_objectmaker;
+    StringArray newPdObjects;
+    {
+        sys_lock();
 
-    auto* mlist = static_cast<t_methodentry*>(libpd_get_class_methods(o));
-    t_methodentry* m;
+        t_class* o = pd_objectmaker;
 
-    allObjects.clear();
+        auto* mlist = static_cast<t_methodentry*>(libpd_get_class_methods(o));
+        t_methodentry* m;
 
-    int i;
-    for (i = o->c_nmethod, m = mlist; i--; m++) {
-        if (!m || !m->me_name)
-            continue;
+        int i;
+        for (i = o->c_nmethod, m = mlist; i--; m++) {
+            if (!m || !m->me_name)
+                continue;
 
-        auto newName = String::fromUTF8(m->me_name->s_name);
-        if (!(newName.startsWith("else/") || newName.startsWith("cyclone/") || newName.endsWith("_aliased"))) {
-            allObjects.add(newName);
+            auto newName = String::fromUTF8(m->me_name->s_name);
+            if (!(newName.startsWith("else/") || newName.startsWith("cyclone/") || newName.endsWith("_aliased"))) {
+                newPdObjects.add(newName);
+            }
         }
+
+        sys_unlock();
     }
 
-    // Find patches in our search tree
-    for (auto path : pathTree) {
-        auto filePath = path.getProperty("Path").toString();
+    // Use the abstractions from the last scan for now, the search paths are rescanned in the background
+    auto newAbstractions = resources->getAbstractions();
+    auto usage = resources->getObjectUsage();
+    {
+        std::lock_guard<std::recursive_mutex> lock(libraryLock);
+        pdObjects = newPdObjects;
+        abstractions = newAbstractions;
+    }
 
-        auto file = File(filePath);
-        if (!file.exists() || !file.isDirectory())
-            continue;
+    rebuildObjectList(usage);
+    resources->scheduleScan();
+}
 
-        for (auto const& file : OSUtils::iterateDirectory(file, false, true)) {
-            if (file.hasFileExtension("pd")) {
-                auto filename = file.getFileNameWithoutExtension();
-                if (!filename.startsWith("help-") || filename.endsWith("-help")) {
-                    allObjects.add(filename);
-                }
-            }
-        }
+void Library::setAbstractions(StringArray const& newAbstractions, std::unordered_map<String, int> const& usage)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(libraryLock);
+        abstractions = newAbstractions;
+    }
+
+    rebuildObjectList(usage);
+}
+
+void Library::rebuildObjectList(std::unordered_map<String, int> const& usage)
+{
+    std::lock_guard<std::mutex> rebuild(rebuildLock);
+
+    StringArray newObjects;
+    {
+        std::lock_guard<std::recursive_mutex> lock(libraryLock);
+        newObjects = pdObjects;
+        newObjects.addArray(abstractions);
     }
 
     // These can't be created by name in Pd, but plugdata allows it
-    allObjects.add("graph");
-    allObjects.add("garray");
-    
+    newObjects.add("graph");
+    newObjects.add("garray");
 
     // These aren't in there but should be
-    allObjects.add("float");
-    allObjects.add("symbol");
-    allObjects.add("list");
+    newObjects.add("float");
+    newObjects.add("symbol");
+    newObjects.add("list");
 
-    sys_unlock();
+    PrefixTrie newTrie;
+    for (auto const& [name, count] : usage) {
+        newTrie.setUsage(name, count);
+    }
+    for (auto const& name : newObjects) {
+        newTrie.insert(name);
+    }
+
+    // Sorted, so the order in which externals were loaded doesn't matter
+    auto sortedObjects = newObjects;
+    sortedObjects.sort(false);
+    auto newStateKey = String(ProjectInfo::versionString) + "_" + String::toHexString(sortedObjects.joinIntoString(" ").hashCode64());
+
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    allObjects = std::move(newObjects);
+    stateKey = std::move(newStateKey);
+    objectTrie = std::move(newTrie);
 }
 
 Library::Library(pd::Instance* instance)
 {
-    MemoryInputStream instream(BinaryData::Documentation_bin, BinaryData::Documentation_binSize, false);
-    documentationTree = ValueTree::readFromStream(instream);
-
-    for (auto object : documentationTree) {
-        auto categories = object.getChildWithName("categories");
-        if (!categories.isValid())
-            continue;
-
-        for (auto category : categories) {
-            allCategories.addIfNotAlreadyThere(category.getProperty("name").toString());
-        }
+    for (auto const& [name, count] : resources->getObjectUsage()) {
+        objectTrie.setUsage(name, count);
     }
 
-    watcher.addFolder(ProjectInfo::appDataDir);
-    watcher.addListener(this);
+    resources->addLibrary(this);
 
-    // Paths to search
-    // First, only search vanilla, then search all documentation
-    // Lastly, check the deken folder
-    helpPaths = {
-        ProjectInfo::appDataDir.getChildFile("Documentation"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("5.reference"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("9.else"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("10.cyclone"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("11.heavylib"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("13.pdlua"),
-        ProjectInfo::appDataDir.getChildFile("Extra"),
-        ProjectInfo::appDataDir.getChildFile("Externals")
-    };
+    helpPaths = defaultHelpPaths;
 
     // This is unfortunately necessary to make Windows LV2 turtle dump work
     // Let's hope its not harmful
@@ -136,83 +149,470 @@ Library::Library(pd::Instance* instance)
     });
 }
 
+Library::~Library()
+{
+    appDirChanged = nullptr;
+    resources->removeLibrary(this);
+}
+
 StringArray Library::autocomplete(String const& query, File const& patchDirectory) const
 {
+    int const maxSuggestions = PrefixTrie::maxRankedResults;
+
     StringArray result;
-    result.ensureStorageAllocated(20);
+    result.ensureStorageAllocated(maxSuggestions);
 
     if (patchDirectory.isDirectory()) {
-        for (auto const& file : OSUtils::iterateDirectory(patchDirectory, false, true, 20)) {
-            auto filename = file.getFileNameWithoutExtension();
-            if (file.hasFileExtension("pd") && filename.startsWith(query) && !filename.startsWith("help-") && !filename.endsWith("-help")) {
+        for (auto const& filename : resources->directoryListings.getAbstractions(patchDirectory)) {
+            if (result.size() >= maxSuggestions)
+                break;
+
+            if (filename.startsWith(query)) {
                 result.add(filename);
             }
         }
     }
 
-    for (auto const& str : allObjects) {
-        if (result.size() >= 20)
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+
+    for (auto const& name : objectTrie.findWithPrefix(query, maxSuggestions)) {
+        if (result.size() >= maxSuggestions)
             break;
 
-        if (str.startsWith(query)) {
-            result.addIfNotAlreadyThere(str);
-        }
+        result.addIfNotAlreadyThere(name);
     }
 
     return result;
 }
 
-void Library::getExtraSuggestions(int currentNumSuggestions, String const& query, std::function<void(StringArray)> const& callback)
+void Library::recordObjectUsage(String const& name)
 {
+    // Usage counts are shared, this updates the ranking of every instance
+    resources->recordObjectUsage(name);
+}
 
-    int const maxSuggestions = 20;
-    if (currentNumSuggestions > maxSuggestions)
-        return;
+void Library::setObjectUsage(String const& name, int count)
+{
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    objectTrie.setUsage(name, count);
+}
 
-    objectSearchThread.addJob([this, callback, query]() mutable {
-        StringArray result;
-        StringArray matches;
+LibraryResources::LibraryResources()
+{
+    auto usageTree = ValueTree::fromXml(ProjectInfo::appDataDir.getChildFile(".object_usage").loadFileAsString());
+    for (auto object : usageTree) {
+        objectUsage[object.getProperty("name").toString()] = object.getProperty("count");
+    }
 
-        for (const auto& object : getAllObjects()) {
-            auto info = getObjectInfo(object);
+    // Rescanning is expensive, and the whole app data folder is watched: wait a bit longer for changes to settle
+    setDebounceTime(500, 5000);
 
-            auto description = info.getProperty("description").toString();
+    watcher.addFolder(ProjectInfo::appDataDir);
+    watcher.addListener(this);
+}
 
-            auto iolets = info.getChildWithName("iolets");
-            auto arguments = info.getChildWithName("arguments");
+LibraryResources::~LibraryResources()
+{
+    watcher.removeListener(this);
+    searchThread.removeAllJobs(true, -1);
+    saveObjectUsage();
+}
 
-            if (description.contains(query) || object.contains(query)) {
-                matches.addIfNotAlreadyThere(object);
-            }
+void LibraryResources::addLibrary(Library* library)
+{
+    std::lock_guard<std::mutex> lock(resourcesLock);
+    libraries.addIfNotAlreadyThere(library);
+}
 
-            for (auto arg : arguments) {
-                auto argDescription = arg.getProperty("description").toString();
-                if (argDescription.contains(query)) {
-                    matches.addIfNotAlreadyThere(object);
-                }
-            }
+void LibraryResources::removeLibrary(Library* library)
+{
+    // Search jobs hold a pointer to their library, so wait for this library's jobs to finish
+    struct JobsForLibrary : public ThreadPool::JobSelector {
+        explicit JobsForLibrary(Library* l)
+            : library(l)
+        {
+        }
 
-            for (auto iolet : iolets) {
-                auto ioletDescription = iolet.getProperty("description").toString();
-                if (description.contains(query)) {
-                    matches.addIfNotAlreadyThere(object);
-                }
-            }
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            auto* searchJob = dynamic_cast<Library::SearchJob*>(job);
+            return searchJob && searchJob->library == library;
         }
 
-        matches.sort(true);
-        result.addArray(matches);
-        matches.clear();
+        Library* library;
+    };
+
+    JobsForLibrary selector(library);
+    searchThread.removeAllJobs(true, -1, &selector);
+
+    std::lock_guard<std::mutex> lock(resourcesLock);
+    libraries.removeFirstMatchingValue(library);
+}
+
+StringArray LibraryResources::getAbstractions()
+{
+    std::lock_guard<std::mutex> lock(resourcesLock);
+    return abstractions;
+}
+
+void LibraryResources::scheduleScan()
+{
+    // A scan that hasn't started yet will already see the latest changes
+    if (scanPending.exchange(true))
+        return;
 
-        MessageManager::callAsync([callback, result]() {
-            callback(result);
-        });
+    searchThread.addJob([this]() {
+        scanPending = false;
+        scanLibrary();
     });
 }
 
+bool LibraryResources::findIndexedHelpfile(File const& directory, StringArray const& names, File& result)
+{
+    std::lock_guard<std::mutex> lock(resourcesLock);
+
+    if (!helpFileIndexIsComplete)
+        return false;
+
+    auto indexed = helpFileIndex.find(directory.getFullPathName());
+    if (indexed == helpFileIndex.end())
+        return false;
+
+    for (auto const& name : names) {
+        if (indexed->second.contains(name)) {
+            result = directory.getChildFile(name);
+            return true;
+        }
+    }
+
+    result = File();
+    return true;
+}
+
+LibraryResources::CachedDirectory const& LibraryResources::listDirectory(File const& directory, std::unordered_set<String>& visited, bool& cacheChanged)
+{
+    auto key = directory.getFullPathName();
+    visited.insert(key);
+
+    auto modificationTime = directory.getLastModificationTime().toMilliseconds();
+    auto existing = directoryCache.find(key);
+    if (existing != directoryCache.end() && existing->second.modificationTime == modificationTime)
+        return existing->second;
+
+    CachedDirectory listing { modificationTime, {}, {}, {} };
+    for (auto const& file : OSUtils::iterateDirectory(directory, false, false)) {
+        if (file.isDirectory()) {
+            listing.subdirectories.add(file.getFileName());
+            continue;
+        }
+
+        if (!file.hasFileExtension("pd"))
+            continue;
+
+        auto filename = file.getFileNameWithoutExtension();
+        if (!filename.startsWith("help-") || filename.endsWith("-help")) {
+            listing.abstractions.add(filename);
+        }
+        if (filename.startsWith("help-") || filename.endsWith("-help")) {
+            listing.helpFiles.add(file.getFileName());
+        }
+    }
+
+    cacheChanged = true;
+    return directoryCache[key] = std::move(listing);
+}
+
+void LibraryResources::scanLibrary()
+{
+    StartupTrace::ScopedPhase tracePhase("Scan library");
+
+    // If the documentation is still being extracted, the help file index will be incomplete
+    // Extracting changes the app data folder, so we'll be asked to scan again
+    auto helpPathsAreComplete = !FilesystemExtractor::getInstance()->isExtracting();
+
+    auto settingsTree = ValueTree::fromXml(ProjectInfo::appDataDir.getChildFile(".settings").loadFileAsString());
+    auto pathTree = settingsTree.getChildWithName("Paths");
+
+    Array<File> searchPaths;
+    for (auto path : pathTree) {
+        searchPaths.addIfNotAlreadyThere(File(path.getProperty("Path").toString()));
+    }
+
+    if (!directoryCacheLoaded) {
+        loadDirectoryCache();
+        directoryCacheLoaded = true;
+    }
+
+    // A directory's modification time only changes when entries are added, removed or renamed, which is all we need
+    bool cacheChanged = false;
+    std::unordered_set<String> visited;
+
+    // Search paths aren't searched recursively
+    StringArray foundAbstractions;
+    for (auto const& path : searchPaths) {
+        if (path.isDirectory())
+            foundAbstractions.addArray(listDirectory(path, visited, cacheChanged).abstractions);
+    }
+
+    // Help files are searched for in every directory below the help paths
+    std::unordered_map<String, StringArray> newHelpFileIndex;
+    std::function<void(File const&, int)> indexHelpFiles = [&](File const& directory, int depth) {
+        auto key = directory.getFullPathName();
+        if (newHelpFileIndex.count(key))
+            return;
+
+        auto const& listing = listDirectory(directory, visited, cacheChanged);
+        newHelpFileIndex[key] = listing.helpFiles;
+
+        if (depth >= maxHelpDirectoryDepth)
+            return;
+
+        for (auto const& subdirectory : StringArray(listing.subdirectories)) {
+            indexHelpFiles(directory.getChildFile(subdirectory), depth + 1);
+        }
+    };
+
+    for (auto const& path : Library::defaultHelpPaths) {
+        if (path.isDirectory())
+            indexHelpFiles(path, 0);
+    }
+
+    // Forget directories that we didn't come across anymore
+    for (auto it = directoryCache.begin(); it != directoryCache.end();) {
+        if (!visited.count(it->first)) {
+            it = directoryCache.erase(it);
+            cacheChanged = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (cacheChanged)
+        saveDirectoryCache();
+
+    std::lock_guard<std::mutex> lock(resourcesLock);
+    helpFileIndex = std::move(newHelpFileIndex);
+    helpFileIndexIsComplete = helpPathsAreComplete;
+
+    if (foundAbstractions == abstractions)
+        return;
+
+    abstractions = foundAbstractions;
+    for (auto* library : libraries) {
+        library->setAbstractions(abstractions, objectUsage);
+    }
+}
+
+File LibraryResources::getDirectoryCacheFile()
+{
+    return ProjectInfo::appDataDir.getChildFile(".abstraction_cache");
+}
+
+void LibraryResources::loadDirectoryCache()
+{
+    FileInputStream input(getDirectoryCacheFile());
+    if (!input.openedOk())
+        return;
+
+    auto cacheTree = ValueTree::readFromStream(input);
+    if (!cacheTree.hasType("AbstractionCache") || static_cast<int>(cacheTree.getProperty("version")) != directoryCacheVersion)
+        return;
+
+    for (auto directory : cacheTree) {
+        auto readList = [&directory](Identifier const& property) {
+            auto list = StringArray::fromLines(directory.getProperty(property).toString());
+            list.removeEmptyStrings();
+            return list;
+        };
+
+        directoryCache[directory.getProperty("path").toString()] = { static_cast<int64>(directory.getProperty("modified")), readList("abstractions"), readList("help"), readList("subdirectories") };
+    }
+}
+
+void LibraryResources::saveDirectoryCache()
+{
+    ValueTree cacheTree("AbstractionCache");
+    cacheTree.setProperty("version", directoryCacheVersion, nullptr);
+
+    for (auto const& [path, cached] : directoryCache) {
+        ValueTree directory("Directory");
+        directory.setProperty("path", path, nullptr);
+        directory.setProperty("modified", cached.modificationTime, nullptr);
+        directory.setProperty("abstractions", cached.abstractions.joinIntoString("\n"), nullptr);
+        directory.setProperty("help", cached.helpFiles.joinIntoString("\n"), nullptr);
+        directory.setProperty("subdirectories", cached.subdirectories.joinIntoString("\n"), nullptr);
+        cacheTree.appendChild(directory, nullptr);
+    }
+
+    // Write to a temporary file first, so an interrupted write never leaves a broken cache
+    TemporaryFile temporary(getDirectoryCacheFile());
+    {
+        FileOutputStream output(temporary.getFile());
+        if (!output.openedOk())
+            return;
+
+        cacheTree.writeToStream(output);
+    }
+
+    temporary.overwriteTargetFileWithTemporary();
+}
+
+void LibraryResources::recordObjectUsage(String const& name)
+{
+    Array<Library*> librariesToUpdate;
+    int count;
+    {
+        std::lock_guard<std::mutex> lock(resourcesLock);
+        count = ++objectUsage[name];
+        librariesToUpdate = libraries;
+    }
+
+    for (auto* library : librariesToUpdate) {
+        library->setObjectUsage(name, count);
+    }
+}
+
+std::unordered_map<String, int> LibraryResources::getObjectUsage()
+{
+    std::lock_guard<std::mutex> lock(resourcesLock);
+    return objectUsage;
+}
+
+void LibraryResources::saveObjectUsage()
+{
+    ValueTree usageTree("ObjectUsage");
+    for (auto const& [name, count] : getObjectUsage()) {
+        ValueTree object("Object");
+        object.setProperty("name", name, nullptr);
+        object.setProperty("count", count, nullptr);
+        usageTree.appendChild(object, nullptr);
+    }
+
+    if (usageTree.getNumChildren())
+        ProjectInfo::appDataDir.getChildFile(".object_usage").replaceWithText(usageTree.toXmlString());
+}
+
+bool LibraryResources::isInterestedIn(File const& file)
+{
+    // Only patches and folders change the abstractions we find
+    return FileSystemWatcher::Listener::isInterestedIn(file) && (file.hasFileExtension("pd") || !file.getFileName().containsChar('.'));
+}
+
+void LibraryResources::filesystemChanged()
+{
+    // Pd's classes don't change when files do, only the abstractions and help files need to be rescanned
+    scheduleScan();
+}
+
+DirectoryListingCache::DirectoryListingCache()
+{
+    watcher.addListener(this);
+}
+
+DirectoryListingCache::~DirectoryListingCache()
+{
+    watcher.removeListener(this);
+}
+
+StringArray DirectoryListingCache::getAbstractions(File const& directory)
+{
+    std::unique_lock<std::mutex> lock(listingsLock);
+
+    auto it = std::find_if(listings.begin(), listings.end(), [&directory](auto const& listing) { return listing.directory == directory; });
+    if (it != listings.end()) {
+        // Move to the front, so the least recently used directory gets evicted first
+        std::rotate(listings.begin(), it, it + 1);
+        if (listings.front().isValid)
+            return listings.front().abstractions;
+    }
+
+    StringArray abstractions;
+    for (auto const& file : OSUtils::iterateDirectory(directory, false, true)) {
+        auto filename = file.getFileNameWithoutExtension();
+        if (file.hasFileExtension("pd") && !filename.startsWith("help-") && !filename.endsWith("-help")) {
+            abstractions.add(filename);
+        }
+    }
+    abstractions.sortNatural();
+
+    if (it != listings.end()) {
+        listings.front() = { directory, abstractions, true };
+        return abstractions;
+    }
+
+    File evictedDirectory;
+    if (listings.size() >= maxCachedDirectories) {
+        evictedDirectory = listings.back().directory;
+        listings.pop_back();
+    }
+
+    listings.insert(listings.begin(), { directory, abstractions, true });
+
+    // The watcher calls fileChanged while holding its own lock, so don't change the watched folders while holding ours
+    lock.unlock();
+
+    if (evictedDirectory != File())
+        watcher.removeFolder(evictedDirectory);
+
+    watcher.addFolder(directory, false);
+
+    return abstractions;
+}
+
+void DirectoryListingCache::fileChanged(File const file, FileSystemWatcher::FileSystemEvent)
+{
+    // Keep the directory watched, the next lookup will list it again
+    // Listings aren't recursive, so the folders aren't watched recursively either
+    std::lock_guard<std::mutex> lock(listingsLock);
+    for (auto& listing : listings) {
+        if (file.getParentDirectory() == listing.directory) {
+            listing.isValid = false;
+        }
+    }
+}
+
+void Library::getExtraSuggestions(int currentNumSuggestions, String const& query, std::function<void(StringArray)> const& callback)
+{
+
+    int const maxSuggestions = 20;
+    if (currentNumSuggestions > maxSuggestions)
+        return;
+
+    resources->searchThread.addJob(new SearchJob(this, query, callback), true);
+}
+
+StringArray Library::searchObjects(String const& query, int maxResults)
+{
+    auto objects = getAllObjects();
+
+    std::unordered_set<String> availableObjects;
+    for (auto const& object : objects) {
+        availableObjects.insert(object);
+    }
+
+    StringArray result;
+    std::unordered_set<String> addedObjects;
+    for (auto const& match : DocumentationIndex::getInstance()->search(query)) {
+        // Only suggest documented objects that can actually be created
+        if (availableObjects.contains(match.name) && addedObjects.insert(match.name).second)
+            result.add(match.name);
+    }
+
+    // Objects without documentation can still be found by name
+    for (auto const& object : objects) {
+        if (object.containsIgnoreCase(query) && addedObjects.insert(object).second)
+            result.add(object);
+    }
+
+    if (maxResults >= 0)
+        result.removeRange(maxResults, result.size());
+
+    return result;
+}
+
 ValueTree Library::getObjectInfo(String const& name)
 {
-    return documentationTree.getChildWithProperty("name", name);
+    return DocumentationIndex::getInstance()->getObjectInfo(name);
 }
 
 std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets, String const& name, int numIn, int numOut)
@@ -270,21 +670,26 @@ std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets,
 
 StringArray Library::getAllObjects()
 {
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
     return allObjects;
 }
 
-StringArray Library::getAllCategories()
+String Library::getStateKey() const
 {
-    return allCategories;
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    return stateKey;
 }
 
-void Library::filesystemChanged()
+StringArray Library::getAllCategories()
 {
-    updateLibrary();
+    return DocumentationIndex::getInstance()->getAllCategories();
 }
 
 File Library::findHelpfile(t_gobj* obj, File const& parentPatchFile) const
 {
+    // On first launch, the documentation might still be extracting
+    FilesystemExtractor::getInstance()->waitForDeferredExtraction();
+
     String helpName;
     String helpDir;
 
@@ -332,7 +737,12 @@ File Library::findHelpfile(t_gobj* obj, File const& parentPatchFile) const
     String firstName = helpName + "-help.pd";
     String secondName = "help-" + helpName + ".pd";
 
-    auto findHelpPatch = [&firstName, &secondName](File const& searchDir) -> File {
+    auto findHelpPatch = [this, &firstName, &secondName](File const& searchDir) -> File {
+        // Most help files are in the help paths, which are indexed in the background
+        File indexedFile;
+        if (resources->findIndexedHelpfile(searchDir, { firstName, secondName }, indexedFile))
+            return indexedFile;
+
         for (const auto& file : OSUtils::iterateDirectory(searchDir, false, true)) {
             auto pathName = file.getFullPathName().replace("\\", "/").trimCharactersAtEnd("/");
             if (pathName.endsWith("/" + firstName) || pathName.endsWith("/" + secondName)) {
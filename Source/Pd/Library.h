@@ -7,31 +7,127 @@
 #pragma once
 
 #include <m_pd.h>
+#include <unordered_set>
 #include "Utility/FileSystemWatcher.h"
+#include "Utility/PrefixTrie.h"
 #include "Utility/Config.h"
 
 namespace pd {
 
 class Instance;
-class Library : public FileSystemWatcher::Listener {
+class Library;
+
+// Caches the abstractions in patch directories, so autocomplete doesn't need to hit the filesystem on every keystroke
+// Directories are watched while they're in the cache, and their listing is dropped when something inside them changes
+class DirectoryListingCache : public FileSystemWatcher::Listener {
+public:
+    static constexpr int maxCachedDirectories = 16;
+
+    DirectoryListingCache();
+    ~DirectoryListingCache() override;
+
+    StringArray getAbstractions(File const& directory);
+
+    void fileChanged(File const file, FileSystemWatcher::FileSystemEvent) override;
+
+private:
+    struct Listing {
+        File directory;
+        StringArray abstractions;
+        bool isValid = true;
+    };
+
+    std::mutex listingsLock;
+    std::vector<Listing> listings; // Most recently used first
+    FileSystemWatcher watcher;
+};
+
+// Everything the libraries of all plugin instances can share: the abstractions found in the search paths, directory
+// listings, object usage counts, the app data folder watcher and the search thread
+// Held through a SharedResourcePointer, so it's created with the first instance and freed with the last one
+// The search paths and help file folders are indexed on the search thread. Listings are cached on disk by directory
+// modification time, so only directories that changed since the last scan (even the last scan of a previous run) are
+// listed again
+class LibraryResources : public FileSystemWatcher::Listener {
+public:
+    LibraryResources();
+    ~LibraryResources() override;
+
+    void addLibrary(Library* library);
+    void removeLibrary(Library* library);
+
+    // Abstractions in the search paths, as of the last finished scan
+    StringArray getAbstractions();
+
+    // Schedules a scan of the search paths in the settings and the help paths
+    // When the abstractions changed, every library is updated
+    void scheduleScan();
+
+    // Looks for the first of the given help file names in a directory using the index
+    // Returns false if the directory isn't indexed (yet), then the caller has to look on disk
+    bool findIndexedHelpfile(File const& directory, StringArray const& names, File& result);
+
+    void recordObjectUsage(String const& name);
+    std::unordered_map<String, int> getObjectUsage();
+
+    bool isInterestedIn(File const& file) override;
+    void filesystemChanged() override;
+
+    DirectoryListingCache directoryListings;
+    ThreadPool searchThread = ThreadPool(1);
+
+private:
+    struct CachedDirectory {
+        int64 modificationTime;
+        StringArray abstractions;
+        StringArray helpFiles;
+        StringArray subdirectories;
+    };
+
+    void scanLibrary();
+    CachedDirectory const& listDirectory(File const& directory, std::unordered_set<String>& visited, bool& cacheChanged);
+    void loadDirectoryCache();
+    void saveDirectoryCache();
+    void saveObjectUsage();
+
+    static File getDirectoryCacheFile();
+    static constexpr int directoryCacheVersion = 2;
+    static constexpr int maxHelpDirectoryDepth = 8;
+
+    std::mutex resourcesLock;
+    StringArray abstractions;
+    std::unordered_map<String, StringArray> helpFileIndex; // Help files in every directory below the help paths
+    bool helpFileIndexIsComplete = false;
+    std::unordered_map<String, int> objectUsage;
+
+    // Only used on the search thread
+    std::unordered_map<String, CachedDirectory> directoryCache;
+    bool directoryCacheLoaded = false;
+    std::atomic<bool> scanPending = false;
+
+    Array<Library*> libraries;
+    FileSystemWatcher watcher;
+};
+
+class Library {
 
 public:
     Library(pd::Instance* instance);
 
-    ~Library() override
-    {
-        appDirChanged = nullptr;
-        objectSearchThread.removeAllJobs(true, -1);
-    }
+    ~Library();
 
     void updateLibrary();
 
     StringArray autocomplete(String const& query, File const& patchDirectory) const;
+
+    // Called when an object is created from an object box, so frequently used objects rank higher in autocomplete
+    void recordObjectUsage(String const& name);
     void getExtraSuggestions(int currentNumSuggestions, String const& query, std::function<void(StringArray)> const& callback);
 
-    static std::array<StringArray, 2> parseIoletTooltips(ValueTree const& iolets, String const& name, int numIn, int numOut);
+    // Ranked search over object names and documentation, can be called from any thread
+    StringArray searchObjects(String const& query, int maxResults = -1);
 
-    void filesystemChanged() override;
+    static std::array<StringArray, 2> parseIoletTooltips(ValueTree const& iolets, String const& name, int numIn, int numOut);
 
     File findHelpfile(t_gobj* obj, File const& parentPatchFile) const;
 
@@ -40,6 +136,10 @@ public:
     StringArray getAllObjects();
     StringArray getAllCategories();
 
+    // Changes whenever the plugdata version or the set of creatable objects changes (externals loaded, abstractions
+    // added or removed), for caches of how patches instantiate
+    String getStateKey() const;
+
     Array<File> helpPaths;
 
     std::function<void()> appDirChanged;
@@ -54,18 +154,70 @@ public:
         ProjectInfo::appDataDir.getChildFile("Extra")
     };
 
+    // Paths to search for help files
+    // First, only search vanilla, then search all documentation
+    // Lastly, check the deken folder
+    static inline Array<File> const defaultHelpPaths = {
+        ProjectInfo::appDataDir.getChildFile("Documentation"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("5.reference"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("9.else"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("10.cyclone"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("11.heavylib"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("13.pdlua"),
+        ProjectInfo::appDataDir.getChildFile("Extra"),
+        ProjectInfo::appDataDir.getChildFile("Externals")
+    };
+
     static inline StringArray objectOrigins = { "vanilla", "ELSE", "cyclone", "heavylib", "pdlua" };
 
+    // Called by the shared resources when another instance recorded a usage
+    void setObjectUsage(String const& name, int count);
+
+    // Called by the shared resources from the search thread when a scan found different abstractions
+    void setAbstractions(StringArray const& newAbstractions, std::unordered_map<String, int> const& usage);
+
+    // Runs searchObjects on the shared search thread
+    struct SearchJob : public ThreadPoolJob {
+        SearchJob(Library* owner, String searchQuery, std::function<void(StringArray)> resultCallback)
+            : ThreadPoolJob("Object search")
+            , library(owner)
+            , query(std::move(searchQuery))
+            , callback(std::move(resultCallback))
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            auto result = library->searchObjects(query);
+
+            MessageManager::callAsync([callback = callback, result]() {
+                callback(result);
+            });
+
+            return jobHasFinished;
+        }
+
+        Library* library;
+        String query;
+        std::function<void(StringArray)> callback;
+    };
+
 private:
+    // Builds the object list and trie without holding the library lock, then swaps them in
+    void rebuildObjectList(std::unordered_map<String, int> const& usage);
+
+    // The object list depends on which externals this Pd instance loaded, so it isn't shared
     StringArray allObjects;
-    StringArray allCategories;
+    String stateKey;
+    mutable PrefixTrie objectTrie;
 
-    std::recursive_mutex libraryLock;
+    StringArray pdObjects;
+    StringArray abstractions;
 
-    FileSystemWatcher watcher;
-    ThreadPool objectSearchThread = ThreadPool(1);
+    mutable std::recursive_mutex libraryLock;
+    std::mutex rebuildLock; // Rebuilds run one at a time, so the last one to start always wins
 
-    ValueTree documentationTree;
+    SharedResourcePointer<LibraryResources> resources;
 };
 
 } // namespace pd
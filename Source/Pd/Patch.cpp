@@ -143,6 +143,12 @@ void Patch::updateUndoRedoState()
         isPatchDirty = patch->gl_dirty;
 
         auto undoSize = pd::Interface::getUndoSize(patch.get());
+        auto* lastAction = pd::Interface::getLastUndoAction(patch.get());
+        if (undoQueueSize != undoSize || lastUndoAction != lastAction) {
+            lastUndoAction = lastAction;
+            editRevision++;
+        }
+
         if (undoQueueSize != undoSize) {
             undoQueueSize = undoSize;
             updateUndoRedoString();
@@ -714,15 +720,28 @@ void Patch::setCurrentFile(File newFile)
 
 String Patch::getCanvasContent()
 {
-    char* buf;
-    int bufsize;
+    return canvasContentToString(snapshotCanvasContent());
+}
 
+t_binbuf* Patch::snapshotCanvasContent()
+{
     if (auto patch = ptr.get<t_canvas>()) {
-        pd::Interface::getCanvasContent(patch.get(), &buf, &bufsize);
-    } else {
-        return {};
+        return pd::Interface::getCanvasBinbuf(patch.get());
     }
 
+    return nullptr;
+}
+
+String Patch::canvasContentToString(t_binbuf* snapshot)
+{
+    if (!snapshot)
+        return {};
+
+    char* buf;
+    int bufsize;
+    binbuf_gettext(snapshot, &buf, &bufsize);
+    binbuf_free(snapshot);
+
     auto content = String::fromUTF8(buf, static_cast<size_t>(bufsize));
 
     freebytes(static_cast<void*>(buf), static_cast<size_t>(bufsize) * sizeof(char));
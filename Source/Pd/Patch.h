@@ -77,6 +77,9 @@ public:
     void setCurrent();
 
     bool isDirty() const;
+
+    // Changes whenever the undo queue changes, so we can tell if the patch was edited since we last looked
+    uint32 getEditRevision() const { return editRevision.load(); }
     bool canUndo() const;
     bool canRedo() const;
 
@@ -107,11 +110,22 @@ public:
         return ptr.get<t_canvas>();
     }
 
+    // Returns the pointer without locking or checking if it's still valid, only use this to identify the patch
+    t_canvas* getUncheckedPointer() const
+    {
+        return ptr.getRawUnchecked<t_canvas>();
+    }
+
     // Gets the objects of the patch.
     std::vector<pd::WeakReference> getObjects();
 
     String getCanvasContent();
 
+    // Copies the patch into a binbuf, only holding the Pd lock while copying
+    // canvasContentToString turns it into text without the lock, and frees the snapshot
+    t_binbuf* snapshotCanvasContent();
+    static String canvasContentToString(t_binbuf* snapshot);
+
     static void reloadPatch(File const& changedPatch, t_glist* except);
 
     String getTitle() const;
@@ -143,6 +157,8 @@ private:
     friend class Object;
 
     int undoQueueSize = 0;
+    void* lastUndoAction = nullptr;
+    std::atomic<uint32> editRevision = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Patch)
 };
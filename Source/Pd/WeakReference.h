@@ -101,7 +101,7 @@ struct WeakReference {
         return reinterpret_cast<T*>(ptr);
     }
 
-    bool isValid()
+    bool isValid() const
     {
         return weakRef && ptr != nullptr;
     }
@@ -23,6 +23,7 @@
 #include "Connection.h"
 #include "Objects/ObjectBase.h" // TODO: We shouldn't need this!
 #include "Dialogs/ConnectionMessageDisplay.h"
+#include "Dialogs/SignalProbePanel.h"
 #include "Dialogs/Dialogs.h"
 #include "Statusbar.h"
 #include "Tabbar/TabBarButtonComponent.h"
@@ -254,6 +255,10 @@ PluginEditor::PluginEditor(PluginProcessor& p)
     connectionMessageDisplay = std::make_unique<ConnectionMessageDisplay>();
     addChildComponent(connectionMessageDisplay.get());
 
+    signalProbePanel = std::make_unique<SignalProbePanel>(*pd->signalProbes);
+    signalProbePanel->onSizeChanged = [this]() { resized(); };
+    addChildComponent(signalProbePanel.get());
+
     // This cannot be done in MidiDeviceManager's constructor because SettingsFile is not yet initialised at that time
     if (ProjectInfo::isStandalone) {
         auto* midiDeviceManager = ProjectInfo::getMidiDeviceManager();
@@ -419,6 +424,9 @@ void PluginEditor::resized()
 
     zoomLabel->setBounds(paletteWidth + 5, getHeight() - Statusbar::statusbarHeight - 36, 55, 23);
 
+    if (signalProbePanel)
+        signalProbePanel->setTopLeftPosition(splitView.getRight() - signalProbePanel->getWidth() - 8, toolbarHeight + workAreaHeight - signalProbePanel->getHeight() - 8);
+
     int buttonDisctance = 56;
     mainMenuButton.setBounds(offset, 0, toolbarHeight, toolbarHeight);
     undoButton.setBounds(buttonDisctance + offset, 0, toolbarHeight, toolbarHeight);
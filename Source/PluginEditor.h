@@ -24,6 +24,7 @@
 #include "Utility/ObjectThemeManager.h"
 
 class ConnectionMessageDisplay;
+class SignalProbePanel;
 class Sidebar;
 class Statusbar;
 class ZoomLabel;
@@ -121,6 +122,7 @@ public:
     PluginProcessor* pd;
 
     std::unique_ptr<ConnectionMessageDisplay> connectionMessageDisplay;
+    std::unique_ptr<SignalProbePanel> signalProbePanel;
 
     OwnedArray<Canvas, CriticalSection> canvases;
     std::unique_ptr<Sidebar> sidebar;
@@ -5,6 +5,7 @@
  */
 #include <clocale>
 #include <memory>
+#include <optional>
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
@@ -20,6 +21,11 @@
 #include "Utility/OSUtils.h"
 #include "Utility/AudioSampleRingBuffer.h"
 #include "Utility/MidiDeviceManager.h"
+#include "Utility/SignalProbes.h"
+#include "Utility/PatchSearchIndex.h"
+#include "Utility/FilesystemExtractor.h"
+#include "Utility/StartupTrace.h"
+#include "Pd/AbstractionGraph.h"
 #include "Dialogs/ConnectionMessageDisplay.h"
 
 #include "Utility/Presets.h"
@@ -80,6 +86,8 @@ PluginProcessor::PluginProcessor()
     , pd::Instance("plugdata")
     , internalSynth(std::make_unique<InternalSynth>())
 {
+    StartupTrace::ScopedPhase tracePhase("Create plugin instance", instanceId);
+
     // Make sure to use dots for decimal numbers, pd requires that
     std::setlocale(LC_ALL, "C");
 
@@ -89,12 +97,20 @@ PluginProcessor::PluginProcessor()
         LookAndFeel::setDefaultLookAndFeel(&lnf.get());
 
         // Initialise directory structure and settings file
-        initialiseFilesystem();
-        settingsFile = SettingsFile::getInstance()->initialise();
+        {
+            StartupTrace::ScopedPhase filesystemPhase("Initialise filesystem", instanceId);
+            initialiseFilesystem();
+        }
+        {
+            StartupTrace::ScopedPhase settingsPhase("Initialise settings", instanceId);
+            settingsFile = SettingsFile::getInstance()->initialise();
+        }
     }
 
     statusbarSource = std::make_unique<StatusbarSource>();
 
+    std::optional<StartupTrace::ScopedPhase> parametersPhase(std::in_place, "Create parameters", instanceId);
+
     auto* volumeParameter = new PlugDataParameter(this, "volume", 0.8f, true, 0, 0.0f, 1.0f);
     addParameter(volumeParameter);
     volume = volumeParameter->getValuePointer();
@@ -108,6 +124,8 @@ PluginProcessor::PluginProcessor()
         addParameter(parameter);
     }
 
+    parametersPhase.reset();
+
     // Make sure that the parameter valuetree has a name, to prevent assertion failures
     // parameters.replaceState(ValueTree("plugdata"));
 
@@ -132,6 +150,8 @@ PluginProcessor::PluginProcessor()
 
     sendMessagesFromQueue();
 
+    std::optional<StartupTrace::ScopedPhase> themePhase(std::in_place, "Set up theme", instanceId);
+
     auto themeName = settingsFile->getProperty<String>("theme");
 
     // Make sure theme exists
@@ -144,6 +164,8 @@ PluginProcessor::PluginProcessor()
     setTheme(themeName, true);
     settingsFile->saveSettings();
 
+    themePhase.reset();
+
     oversampling = settingsFile->getProperty<int>("oversampling");
 
     setProtectedMode(settingsFile->getProperty<int>("protected"));
@@ -153,12 +175,23 @@ PluginProcessor::PluginProcessor()
 
     // ag: This needs to be done *after* the library data has been unpacked on
     // first launch.
-    initialisePd(pdlua_version);
+    {
+        StartupTrace::ScopedPhase pdPhase("Initialise Pd", instanceId);
+        initialisePd(pdlua_version);
+    }
     logMessage(pdlua_version);
 
-    updateSearchPaths();
+    {
+        StartupTrace::ScopedPhase searchPathsPhase("Update search paths", instanceId);
+        updateSearchPaths();
+    }
 
-    objectLibrary = std::make_unique<pd::Library>(this);
+    {
+        StartupTrace::ScopedPhase libraryPhase("Create object library", instanceId);
+        objectLibrary = std::make_unique<pd::Library>(this);
+    }
+    signalProbes = std::make_unique<SignalProbeManager>(this);
+    searchIndex = std::make_unique<PatchSearchIndex>(this);
 
     setLatencySamples(pd::Instance::getBlockSize());
 }
@@ -177,35 +210,19 @@ void PluginProcessor::initialiseFilesystem()
     auto patches = homeDir.getChildFile("Patches");
 
     // Check if the abstractions directory exists, if not, unzip it from binaryData
-    if (!homeDir.exists() || !versionDataDir.exists()) {
-
-        // Binary data shouldn't be too big, then the compiler will run out of memory
-        // To prevent this, we split the binarydata into multiple files, and add them back together here
-        std::vector<char> allData;
-        int i = 0;
-        while (true) {
-            int size;
-            auto* resource = BinaryData::getNamedResource((String("Filesystem_") + String(i) + "_zip").toRawUTF8(), size);
-
-            if (!resource) {
-                break;
-            }
-
-            allData.insert(allData.end(), resource, resource + size);
-            i++;
-        }
-
-        MemoryInputStream memstream(allData.data(), allData.size(), false);
-
+    // This also resumes an extraction that was interrupted, unless another instance is already extracting
+    auto* extractor = FilesystemExtractor::getInstance();
+    if ((!homeDir.exists() || FilesystemExtractor::isIncomplete(versionDataDir)) && !extractor->isExtracting()) {
         homeDir.createDirectory();
 
-        auto file = ZipFile(memstream);
-        file.uncompressTo(homeDir);
-
-        // Create filesystem for this specific version
-        versionDataDir.getParentDirectory().createDirectory();
-        versionDataDir.createDirectory();
-        homeDir.getChildFile("plugdata_version").moveFileTo(versionDataDir);
+        // The documentation is only needed when opening help files, so we extract it in the background
+        // On iOS, the directories get copied below, so they need to be complete
+#if JUCE_IOS
+        StringArray deferredDirectories;
+#else
+        StringArray deferredDirectories = { "Documentation" };
+#endif
+        extractor->extract(versionDataDir, deferredDirectories, { "Documentation/7.stuff/tools/testtone.pd", "Documentation/7.stuff/tools/load-meter.pd" });
     }
     if (!deken.exists()) {
         deken.createDirectory();
@@ -457,6 +474,8 @@ void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     limiter.prepare({ sampleRate, static_cast<uint32>(samplesPerBlock), std::max(1u, static_cast<uint32>(maxChannels)) });
 
     smoothedGain.reset(AudioProcessor::getSampleRate(), 0.02);
+    stateLoadFade.reset(AudioProcessor::getSampleRate(), 0.01);
+    lastOutputSamples.assign(std::max(1, maxChannels), 0.0f);
 }
 
 void PluginProcessor::releaseResources()
@@ -534,6 +553,36 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
+    // While setStateInformation replaces the patches, never wait for it to release the lock
+    // Output is muted until the new patches are in place: fade out while we can still run Pd, and if the lock was
+    // already taken, fade out the last output sample instead, so the output never jumps to zero
+    bool const loadingState = stateLoadInProgress.load();
+    stateLoadFade.setTargetValue(loadingState ? 0.0f : 1.0f);
+
+    if (loadingState && (stateLoadFadedOut.load() || !tryLockAudioThread())) {
+        buffer.clear();
+
+        // The last output already had the current fade gain applied, so ramp it down relative to that
+        auto const numChannels = std::min(buffer.getNumChannels(), static_cast<int>(lastOutputSamples.size()));
+        auto const startGain = stateLoadFade.getCurrentValue();
+        if (stateLoadFade.isSmoothing() && startGain > 0.0f) {
+            for (int n = 0; n < buffer.getNumSamples(); n++) {
+                auto const gain = stateLoadFade.getNextValue() / startGain;
+                for (int ch = 0; ch < numChannels; ch++) {
+                    buffer.setSample(ch, n, lastOutputSamples[ch] * gain);
+                }
+            }
+        }
+
+        if (!stateLoadFade.isSmoothing()) {
+            std::fill(lastOutputSamples.begin(), lastOutputSamples.end(), 0.0f);
+            setStateLoadFadedOut();
+        }
+
+        midiMessages.clear();
+        return;
+    }
+
     setThis();
     sendPlayhead();
     sendParameters();
@@ -593,6 +642,8 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
     smoothedGain.setTargetValue(mappedTargetGain);
     smoothedGain.applyGain(buffer, buffer.getNumSamples());
 
+    stateLoadFade.applyGain(buffer, buffer.getNumSamples());
+
     statusbarSource->process(hasMidiInEvents, hasMidiOutEvents, totalNumOutputChannels);
     statusbarSource->setCPUUsage(cpuLoadMeasurer.getLoadAsPercentage());
     statusbarSource->peakBuffer.write(buffer);
@@ -638,6 +689,24 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
         auto block = dsp::AudioBlock<float>(buffer);
         limiter.process(block);
     }
+
+    // Kept for fading out when a state load takes the lock before we could fade out ourselves
+    for (int ch = 0; ch < std::min(buffer.getNumChannels(), static_cast<int>(lastOutputSamples.size())); ch++) {
+        lastOutputSamples[ch] = buffer.getNumSamples() > 0 ? buffer.getSample(ch, buffer.getNumSamples() - 1) : 0.0f;
+    }
+
+    if (loadingState) {
+        if (!stateLoadFade.isSmoothing())
+            setStateLoadFadedOut();
+
+        unlockAudioThread();
+    }
+}
+
+void PluginProcessor::setStateLoadFadedOut()
+{
+    if (!stateLoadFadedOut.exchange(true))
+        stateLoadFadedOutEvent.signal();
 }
 
 
@@ -691,6 +760,8 @@ void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer&
 
         sendMessagesFromQueue();
 
+        publishSnapshots();
+
         if (connectionListener && plugdata_debugging_enabled())
             connectionListener->updateSignalData();
 
@@ -750,6 +821,8 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
 
         sendMessagesFromQueue();
 
+        publishSnapshots();
+
         if (connectionListener && plugdata_debugging_enabled())
             connectionListener->updateSignalData();
 
@@ -924,6 +997,8 @@ bool PluginProcessor::hasEditor() const
 
 AudioProcessorEditor* PluginProcessor::createEditor()
 {
+    StartupTrace::ScopedPhase tracePhase("Create editor", instanceId);
+
     auto* editor = new PluginEditor(*this);
     setThis();
 
@@ -959,83 +1034,78 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
 
     savePatchTabPositions();
 
-    // Store pure-data and parameter state
-    MemoryOutputStream ostream(destData, false);
+    struct PatchState {
+        t_binbuf* snapshot;
+        String location;
+        bool pluginMode;
+        int splitIndex;
+    };
 
-    ostream.writeInt(patches.size());
+    std::vector<PatchState> patchStates;
+    patchStates.reserve(patches.size());
 
-    // Save path and content for patch
+    // Only copying the patches needs the lock, turning them into text and compressing them is done without blocking the audio thread
     lockAudioThread();
-
-    auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
-
-    auto patchesTree = new XmlElement("Patches");
-
     for (auto const& patch : patches) {
+        patchStates.push_back({ patch->snapshotCanvasContent(), patch->getCurrentFile().getFullPathName(), patch->openInPluginMode, patch->splitViewIndex });
+    }
+    unlockAudioThread();
 
-        auto content = patch->getCanvasContent();
-        auto patchFile = patch->getCurrentFile().getFullPathName();
+    // Patches that are opened more than once are only stored once
+    StringArray contents;
+    std::vector<int> contentIndices;
+    for (auto const& state : patchStates) {
+        auto content = pd::Patch::canvasContentToString(state.snapshot);
+        auto index = contents.indexOf(content);
+        if (index < 0) {
+            index = contents.size();
+            contents.add(content);
+        }
+        contentIndices.push_back(index);
+    }
 
-        // Write legacy format
-        ostream.writeString(content);
-        ostream.writeString(patchFile);
+    // The header is left uncompressed, so we can tell it apart from the legacy format
+    MemoryOutputStream ostream(destData, false);
+    ostream.writeInt(compactStateMagic);
+    ostream.writeInt(compactStateVersion);
 
-        auto* patchTree = new XmlElement("Patch");
-        // Write new format
-        patchTree->setAttribute("Content", content);
-        patchTree->setAttribute("Location", patchFile);
-        patchTree->setAttribute("PluginMode", patch->openInPluginMode);
-        patchTree->setAttribute("SplitIndex", patch->splitViewIndex);
+    GZIPCompressorOutputStream body(ostream);
 
-        patchesTree->addChildElement(patchTree);
-    }
-    unlockAudioThread();
+    body.writeString(PLUGDATA_VERSION);
 
-    ostream.writeInt(getLatencySamples());
-    ostream.writeInt(oversampling);
-    ostream.writeFloat(getValue<float>(tailLength));
+    body.writeCompressedInt(contents.size());
+    for (auto const& content : contents) {
+        body.writeString(content);
+    }
 
-    auto xml = XmlElement("plugdata_save");
-    xml.setAttribute("Version", PLUGDATA_VERSION);
+    body.writeCompressedInt(static_cast<int>(patchStates.size()));
+    for (size_t i = 0; i < patchStates.size(); i++) {
+        body.writeCompressedInt(contentIndices[i]);
+        body.writeString(patchStates[i].location);
+        body.writeBool(patchStates[i].pluginMode);
+        body.writeCompressedInt(patchStates[i].splitIndex);
+    }
 
-    // In the future, we're gonna load everything from xml, to make it easier to add new properties
-    // By putting this here, we can prepare for making this change without breaking existing DAW saves
-    xml.setAttribute("Oversampling", oversampling);
-    xml.setAttribute("Latency", getLatencySamples());
-    xml.setAttribute("TailLength", getValue<float>(tailLength));
-    xml.setAttribute("Legacy", false);
+    body.writeCompressedInt(getLatencySamples());
+    body.writeCompressedInt(oversampling);
+    body.writeFloat(getValue<float>(tailLength));
 
     // TODO: make multi-window friendly
     if (auto* editor = getActiveEditor()) {
-        xml.setAttribute("Width", editor->getWidth());
-        xml.setAttribute("Height", editor->getHeight());
+        body.writeCompressedInt(editor->getWidth());
+        body.writeCompressedInt(editor->getHeight());
     } else {
-        xml.setAttribute("Width", lastUIWidth);
-        xml.setAttribute("Height", lastUIHeight);
+        body.writeCompressedInt(lastUIWidth);
+        body.writeCompressedInt(lastUIHeight);
     }
 
-    xml.addChildElement(patchesTree);
-
-    PlugDataParameter::saveStateInformation(xml, getParameters());
+    PlugDataParameter::saveStateInformation(body, getParameters());
 
     // store additional extra-data in DAW session if they exist.
-    bool extraDataStored = false;
-    if (extraData) {
-        if (extraData->getNumChildElements() > 0) {
-            xml.addChildElement(extraData.get());
-            extraDataStored = true;
-        }
-    }
-
-    MemoryBlock xmlBlock;
-    copyXmlToBinary(xml, xmlBlock);
-
-    ostream.writeInt(static_cast<int>(xmlBlock.getSize()));
-    ostream.write(xmlBlock.getData(), xmlBlock.getSize());
-
-    // then detach extraData XmlElement from temporary tree xml for later re-use
-    if (extraDataStored) {
-        xml.removeChildElement(extraData.get(), false);
+    if (extraData && extraData->getNumChildElements() > 0) {
+        body.writeString(extraData->toString(XmlElement::TextFormat().singleLine().withoutHeader()));
+    } else {
+        body.writeString({});
     }
 }
 
@@ -1043,7 +1113,31 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
 {
     if (sizeInBytes == 0)
         return;
-    
+
+    MemoryInputStream header(data, sizeInBytes, false);
+    bool const isCompactState = sizeInBytes >= 8 && header.readInt() == compactStateMagic;
+
+    // Decompress before taking the lock, so the audio thread doesn't have to wait for it
+    MemoryBlock compactState;
+    if (isCompactState) {
+        // Saved by a newer version of plugdata that we don't know how to read
+        if (header.readInt() > compactStateVersion)
+            return;
+
+        GZIPDecompressorInputStream body(header);
+        body.readIntoMemoryBlock(compactState);
+    }
+
+    // Give the audio thread a few blocks to fade out, after that it won't wait for the lock anymore
+    // If audio isn't running, there is nothing to wait for
+    stateLoadFadedOutEvent.reset();
+    stateLoadFadedOut = false;
+    stateLoadInProgress = true;
+
+    if (getSampleRate() > 0.0) {
+        stateLoadFadedOutEvent.wait(20.0 + 2000.0 * getBlockSize() / getSampleRate());
+    }
+
     // Don't clear tabs if there is no editor open before loading state, if we don't check this it will not load properly in some DAWs
     if(getEditors().size()) {
         // Close any opened patches
@@ -1057,13 +1151,86 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
         });
     }
 
-    MemoryInputStream istream(data, sizeInBytes, false);
-    
     lockAudioThread();
 
     setThis();
+
+    // Build the new patches with DSP suspended, so the DSP chain is only rebuilt once, when all of them are in place
+    // The audio thread picks up the new chain on the first block after we release the lock
+    auto const dspState = canvas_suspend_dsp();
+
     patches.clear();
 
+    if (isCompactState) {
+        setCompactStateInformation(compactState);
+    } else {
+        setLegacyStateInformation(data, sizeInBytes);
+    }
+
+    canvas_resume_dsp(dspState);
+
+    unlockAudioThread();
+
+    stateLoadInProgress = false;
+
+    MessageManager::callAsync([this]() {
+        for (auto* editor : getEditors()) {
+            editor->sidebar->updateAutomationParameters();
+
+            if (editor->pluginMode && !editor->pd->isInPluginMode()) {
+                editor->pluginMode->closePluginMode();
+            }
+        }
+    });
+}
+
+void PluginProcessor::setCompactStateInformation(MemoryBlock const& state)
+{
+    MemoryInputStream istream(state, false);
+
+    auto savedVersion = istream.readString();
+    ignoreUnused(savedVersion);
+
+    StringArray contents;
+    auto numContents = istream.readCompressedInt();
+    for (int i = 0; i < numContents && !istream.isExhausted(); i++) {
+        contents.add(istream.readString());
+    }
+
+    auto presetDir = ProjectInfo::versionDataDir.getChildFile("Extra").getChildFile("Presets");
+
+    auto numPatches = istream.readCompressedInt();
+    for (int i = 0; i < numPatches && !istream.isExhausted(); i++) {
+        auto contentIndex = istream.readCompressedInt();
+        auto location = istream.readString().replace("${PRESET_DIR}", presetDir.getFullPathName());
+        auto pluginMode = istream.readBool();
+        auto splitIndex = istream.readCompressedInt();
+
+        openPatchFromState(contents[contentIndex], location, pluginMode, splitIndex);
+    }
+
+    setLatencySamples(istream.readCompressedInt());
+    setOversampling(istream.readCompressedInt());
+    tailLength = istream.readFloat();
+
+    auto windowWidth = istream.readCompressedInt();
+    auto windowHeight = istream.readCompressedInt();
+    restoreEditorSize(windowWidth, windowHeight);
+
+    PlugDataParameter::loadStateInformation(istream, getParameters());
+
+    // Retrieve additional extra-data from DAW
+    if (auto extraDataXml = parseXML(istream.readString())) {
+        XmlElement xml("plugdata_save");
+        xml.addChildElement(extraDataXml.release());
+        parseDataBuffer(xml);
+    }
+}
+
+void PluginProcessor::setLegacyStateInformation(void const* data, int sizeInBytes)
+{
+    MemoryInputStream istream(data, sizeInBytes, false);
+
     int numPatches = istream.readInt();
 
     Array<std::pair<String, File>> patches;
@@ -1088,32 +1255,6 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
 
     std::unique_ptr<XmlElement> xmlState(getXmlFromBinary(xmlData, xmlSize));
 
-    auto openPatch = [this](String const& content, File const& location, bool pluginMode = false, int splitIndex = 0) {
-        if (location.getFullPathName().isNotEmpty() && location.existsAsFile()) {
-            auto patch = loadPatch(location, getEditors()[0], splitIndex);
-            if (patch) {
-                patch->setTitle(location.getFileName());
-                patch->openInPluginMode = pluginMode;
-            }
-        } else {
-            if (location.getParentDirectory().exists()) {
-                auto parentPath = location.getParentDirectory().getFullPathName();
-                libpd_add_to_search_path(parentPath.toRawUTF8());
-            }
-            auto patch = loadPatch(content, getEditors()[0], splitIndex);
-            if (patch && ((location.exists() && location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory)) || !location.exists())) {
-                patch->setTitle("Untitled Patcher");
-                patch->openInPluginMode = pluginMode;
-                patch->splitViewIndex = splitIndex;
-            } else if (patch && location.existsAsFile()) {
-                patch->setCurrentFile(location);
-                patch->setTitle(location.getFileName());
-                patch->openInPluginMode = pluginMode;
-                patch->splitViewIndex = splitIndex;
-            }
-        }
-    };
-
     if (xmlState) {
         // If xmltree contains new patch format, use that
         if (auto* patchTree = xmlState->getChildByName("Patches")) {
@@ -1130,13 +1271,13 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
                 auto presetDir = ProjectInfo::versionDataDir.getChildFile("Extra").getChildFile("Presets");
                 location = location.replace("${PRESET_DIR}", presetDir.getFullPathName());
 
-                openPatch(content, location, pluginMode, splitIndex);
+                openPatchFromState(content, location, pluginMode, splitIndex);
             }
         }
         // Otherwise, load from legacy format
         else {
             for (auto& [content, location] : patches) {
-                openPatch(content, location);
+                openPatchFromState(content, location);
             }
         }
 
@@ -1161,37 +1302,55 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
         }
 
         if (xmlState->hasAttribute("Height") && xmlState->hasAttribute("Width")) {
-            int windowWidth = xmlState->getIntAttribute("Width", 1000);
-            int windowHeight = xmlState->getIntAttribute("Height", 650);
-            lastUIWidth = windowWidth;
-            lastUIHeight = windowHeight;
-            // TODO: make multi-window friendly
-            if (auto* editor = getActiveEditor()) {
-                MessageManager::callAsync([editor = Component::SafePointer(editor), windowWidth, windowHeight]() {
-                    if (!editor)
-                        return;
-                    editor->setSize(windowWidth, windowHeight);
-                });
-            }
+            restoreEditorSize(xmlState->getIntAttribute("Width", 1000), xmlState->getIntAttribute("Height", 650));
         }
 
         // Retrieve additional extra-data from DAW
         parseDataBuffer(*xmlState);
     }
 
-    unlockAudioThread();
-
     delete[] xmlData;
+}
 
-    MessageManager::callAsync([this]() {
-        for (auto* editor : getEditors()) {
-            editor->sidebar->updateAutomationParameters();
-
-            if (editor->pluginMode && !editor->pd->isInPluginMode()) {
-                editor->pluginMode->closePluginMode();
-            }
+void PluginProcessor::openPatchFromState(String const& content, File const& location, bool pluginMode, int splitIndex)
+{
+    if (location.getFullPathName().isNotEmpty() && location.existsAsFile()) {
+        auto patch = loadPatch(location, getEditors()[0], splitIndex);
+        if (patch) {
+            patch->setTitle(location.getFileName());
+            patch->openInPluginMode = pluginMode;
         }
-    });
+    } else {
+        if (location.getParentDirectory().exists()) {
+            auto parentPath = location.getParentDirectory().getFullPathName();
+            libpd_add_to_search_path(parentPath.toRawUTF8());
+        }
+        auto patch = loadPatch(content, getEditors()[0], splitIndex);
+        if (patch && ((location.exists() && location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory)) || !location.exists())) {
+            patch->setTitle("Untitled Patcher");
+            patch->openInPluginMode = pluginMode;
+            patch->splitViewIndex = splitIndex;
+        } else if (patch && location.existsAsFile()) {
+            patch->setCurrentFile(location);
+            patch->setTitle(location.getFileName());
+            patch->openInPluginMode = pluginMode;
+            patch->splitViewIndex = splitIndex;
+        }
+    }
+}
+
+void PluginProcessor::restoreEditorSize(int windowWidth, int windowHeight)
+{
+    lastUIWidth = windowWidth;
+    lastUIHeight = windowHeight;
+    // TODO: make multi-window friendly
+    if (auto* editor = getActiveEditor()) {
+        MessageManager::callAsync([editor = Component::SafePointer(editor), windowWidth, windowHeight]() {
+            if (!editor)
+                return;
+            editor->setSize(windowWidth, windowHeight);
+        });
+    }
 }
 
 pd::Patch::Ptr PluginProcessor::loadPatch(File const& patchFile, PluginEditor* editor, int splitIndex)
@@ -1678,35 +1837,93 @@ Array<PluginEditor*> PluginProcessor::getEditors() const
 
 void PluginProcessor::reloadAbstractions(File changedPatch, t_glist* except)
 {
+    // Called with the Pd lock held, which also protects the pending reloads
+    // Files that are saved shortly after each other (like when saving all patches) are reloaded together
+    pendingAbstractionReloads.erase(std::remove_if(pendingAbstractionReloads.begin(), pendingAbstractionReloads.end(), [&changedPatch](auto const& reload) {
+        return reload.first == changedPatch;
+    }),
+        pendingAbstractionReloads.end());
+    pendingAbstractionReloads.emplace_back(changedPatch, except);
+
+    if (pendingAbstractionReloads.size() == 1) {
+        MessageManager::callAsync([this]() {
+            performAbstractionReloads();
+        });
+    }
+}
+
+void PluginProcessor::performAbstractionReloads()
+{
+    auto const startTime = Time::getMillisecondCounterHiRes();
+
     setThis();
+    lockAudioThread();
+
+    auto reloads = std::exchange(pendingAbstractionReloads, {});
 
     // Ensure that all messages are dequeued before we start deleting objects
     sendMessagesFromQueue();
 
     isPerformingGlobalSync = true;
 
-    pd::Patch::reloadPatch(changedPatch, except);
-
-    for (auto* editor : getEditors()) {
+    std::set<t_canvas*> affectedCanvases;
+    int numReloadedInstances = 0;
 
-        // Synchronising can potentially delete some other canvases, so make sure we use a safepointer
-        Array<Component::SafePointer<Canvas>> canvases;
+    pd::AbstractionGraph graph;
+    bool graphIsOutdated = true;
 
-        for (auto* canvas : editor->canvases) {
-            canvases.add(canvas);
+    for (auto const& [changedPatch, except] : reloads) {
+        // Reloading replaces the instances, so anything we found before that might be gone
+        if (graphIsOutdated) {
+            graph.rebuild();
+            graphIsOutdated = false;
         }
 
-        for (auto& cnv : canvases) {
-            if (cnv.getComponent()) {
-                cnv->synchronise();
-                cnv->handleUpdateNowIfNeeded();
+        auto numInstances = static_cast<int>(graph.getInstances(changedPatch, except).size());
+        if (numInstances == 0)
+            continue;
+
+        auto dependentCanvases = graph.getDependentCanvases(changedPatch, except);
+        affectedCanvases.insert(dependentCanvases.begin(), dependentCanvases.end());
+
+        pd::Patch::reloadPatch(changedPatch, except);
+
+        numReloadedInstances += numInstances;
+        graphIsOutdated = true;
+    }
+
+    if (numReloadedInstances > 0) {
+        for (auto* editor : getEditors()) {
+
+            // Synchronising can potentially delete some other canvases, so make sure we use a safepointer
+            Array<Component::SafePointer<Canvas>> canvases;
+
+            // Only canvases that show one of the instances, or contain one, have changed
+            // Canvases of instances that were replaced need to synchronise too, so they can close
+            for (auto* canvas : editor->canvases) {
+                if (affectedCanvases.count(canvas->patch.getUncheckedPointer()) || !canvas->patch.getPointer())
+                    canvases.add(canvas);
+            }
+
+            for (auto& cnv : canvases) {
+                if (cnv.getComponent()) {
+                    cnv->synchronise();
+                    cnv->handleUpdateNowIfNeeded();
+                }
             }
-        }
 
-        editor->updateCommandStatus();
+            editor->updateCommandStatus();
+        }
     }
 
     isPerformingGlobalSync = false;
+
+    unlockAudioThread();
+
+    if (numReloadedInstances > 0) {
+        auto reloadTime = Time::getMillisecondCounterHiRes() - startTime;
+        logMessage("Reloaded " + String(numReloadedInstances) + (numReloadedInstances == 1 ? " abstraction instance" : " abstraction instances") + " in " + String(reloadTime, 1) + " ms");
+    }
 }
 
 void PluginProcessor::titleChanged()
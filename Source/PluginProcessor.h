@@ -27,6 +27,8 @@ class StatusbarSource;
 struct PlugDataLook;
 class PluginEditor;
 class ConnectionMessageDisplay;
+class SignalProbeManager;
+class PatchSearchIndex;
 class PluginProcessor : public AudioProcessor
     , public pd::Instance, public SettingsFileListener {
 public:
@@ -170,10 +172,26 @@ public:
 
     OwnedArray<PluginEditor> openedEditors;
     Component::SafePointer<ConnectionMessageDisplay> connectionListener;
+    std::unique_ptr<SignalProbeManager> signalProbes;
+    std::unique_ptr<PatchSearchIndex> searchIndex;
+
+    // Used to tell instances apart in the startup trace
+    static inline std::atomic<int> numInstancesCreated = 0;
+    int const instanceId = ++numInstancesCreated;
 
 private:
     SmoothedValue<float, ValueSmoothingTypes::Linear> smoothedGain;
 
+    // Set while setStateInformation replaces the patches, the audio thread fades out and outputs silence instead of waiting for the lock
+    // This mutes the output for the whole load, the patches can't be built anywhere but in the running Pd instance
+    std::atomic<bool> stateLoadInProgress = false;
+    std::atomic<bool> stateLoadFadedOut = false;
+    WaitableEvent stateLoadFadedOutEvent;
+    SmoothedValue<float, ValueSmoothingTypes::Linear> stateLoadFade { 1.0f };
+    std::vector<float> lastOutputSamples;
+
+    void setStateLoadFadedOut();
+
     int audioAdvancement = 0;
 
     bool variableBlockSize = false;
@@ -205,6 +223,20 @@ private:
 
     std::map<unsigned long, std::unique_ptr<Component>> textEditorDialogs;
 
+    // DAW state is stored as this header followed by a compressed body, see getStateInformation
+    // States that don't start with it are read with the legacy reader
+    static constexpr int compactStateMagic = 0x54534450; // "PDST"
+    static constexpr int compactStateVersion = 1;
+
+    // Reloads all abstractions that were saved since the last reload, and resynchronises the canvases that depend on them
+    void performAbstractionReloads();
+    std::vector<std::pair<File, t_glist*>> pendingAbstractionReloads;
+
+    void setCompactStateInformation(MemoryBlock const& state);
+    void setLegacyStateInformation(void const* data, int sizeInBytes);
+    void openPatchFromState(String const& content, File const& location, bool pluginMode = false, int splitIndex = 0);
+    void restoreEditorSize(int windowWidth, int windowHeight);
+
     static inline String const else_version = "ELSE v1.0-rc10";
     static inline String const cyclone_version = "cyclone v0.8-0";
     static inline String const heavylib_version = "heavylib v0.3.1";
@@ -62,6 +62,18 @@ PaletteItem::~PaletteItem()
         removeMouseListener(paletteComp);
 }
 
+void PaletteItem::visibilityChanged()
+{
+    // Render the drag preview ahead of time, so dragging this item doesn't stall
+    if (isShowing())
+        editor->offlineRenderer.pregenerate(palettePatch);
+}
+
+void PaletteItem::parentHierarchyChanged()
+{
+    visibilityChanged();
+}
+
 bool PaletteItem::hitTest(int x, int y)
 {
     auto hit = false;
@@ -330,8 +342,7 @@ std::pair<std::vector<bool>, std::vector<bool>> PaletteItem::countIolets(String
 
     // In case the patch contains a single object, we need to use a different method to find the number and kind inlets and outlets
     if (lines.size() == 1) {
-        auto offlineObjectRenderer = editor->offlineRenderer;
-        return offlineObjectRenderer.countIolets(lines[0]);
+        return editor->offlineRenderer.countIolets(lines[0]);
     }
 
     for (auto& line : lines) {
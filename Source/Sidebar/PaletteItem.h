@@ -28,6 +28,9 @@ public:
 
     bool hitTest(int x, int y) override;
 
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+
     void deleteItem();
 
     bool isSubpatchOrAbstraction(String const& patchAsString);
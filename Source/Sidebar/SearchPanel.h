@@ -6,6 +6,7 @@
 
 #include "Object.h"
 #include "Objects/ObjectBase.h"
+#include "Utility/PatchSearchIndex.h"
 #include <m_pd.h>
 #include <m_imp.h>
 
@@ -77,7 +78,7 @@ public:
         input.setTextToShowWhenEmpty("Type to search in patch", findColour(PlugDataColour::sidebarTextColourId).withAlpha(0.5f));
 
         input.onTextChange = [this]() {
-            patchTree.setFilterString(input.getText());
+            updateResults();
         };
 
         input.addKeyListener(this);
@@ -114,10 +115,22 @@ public:
     void timerCallback() override
     {
         auto* cnv = editor->getCurrentCanvas();
-        if(cnv && (currentCanvas.getComponent() != cnv || cnv->needsSearchUpdate))
+        if(!cnv)
+            return;
+        
+        // Object positions can change without a synchronise, so update this patch level in the index
+        if(cnv->needsSearchUpdate)
+        {
+            cnv->needsSearchUpdate = false;
+            if(cnv->patch.getPointer())
+                editor->pd->searchIndex->updatePatch(cnv->patch.getUncheckedPointer());
+        }
+        
+        auto generation = editor->pd->searchIndex->getGeneration();
+        if(currentCanvas.getComponent() != cnv || generation != lastGeneration)
         {
             currentCanvas = cnv;
-            currentCanvas->needsSearchUpdate = false;
+            lastGeneration = generation;
             updateResults();
         }
     }
@@ -179,15 +192,30 @@ public:
         return std::unique_ptr<TextButton>(settingsCalloutButton);
     }
     
+    // Queries the search index on a background thread, and shows the result when it's done
+    // Without a filter, we show the tree of the current patch, otherwise the results from all open patches
     void updateResults()
     {
         auto* cnv = editor->getCurrentCanvas();
-        if(cnv) {
-            cnv->pd->lockAudioThread(); // It locks inside of this anyway, so we might as well lock around it to prevent constantly locking/unlocking
-            auto tree = generatePatchTree(cnv->refCountedPatch);
-            patchTree.setValueTree(tree);
-            cnv->pd->unlockAudioThread();
-        }
+        if(!cnv)
+            return;
+        
+        auto* patch = cnv->patch.getUncheckedPointer();
+        auto filter = input.getText();
+        auto queryId = ++lastQueryId;
+        
+        searchThread.addJob([_this = SafePointer(this), index = editor->pd->searchIndex.get(), patch, filter, queryId]() {
+            auto tree = filter.isEmpty() ? index->buildPatchTree(patch) : index->buildSearchTree(filter);
+            
+            MessageManager::callAsync([_this, tree, queryId]() {
+                // Ignore results for queries that were replaced by a newer one
+                if(!_this || queryId != _this->lastQueryId)
+                    return;
+                
+                // The index already filtered the tree, so there is nothing left to search here
+                _this->patchTree.setValueTree(tree);
+            });
+        });
     }
     
     void grabFocus()
@@ -206,55 +234,12 @@ public:
         patchTree.setBounds(tableBounds);
     }
 
-    ValueTree generatePatchTree(pd::Patch::Ptr patch, void* topLevel = nullptr)
-    {
-        ValueTree patchTree("Patch");
-        for (auto objectPtr : patch->getObjects()) {
-            if (auto object = objectPtr.get<t_pd>()) {
-                auto* top = topLevel ? topLevel : object.get();
-                String type = pd::Interface::getObjectClassName(object.get());
-
-                if (!pd::Interface::checkObject(object.get()))
-                    continue;
-
-                char* objectText;
-                int len;
-                pd::Interface::getObjectText(object.cast<t_text>(), &objectText, &len);
-
-                int x, y, w, h;
-                pd::Interface::getObjectBounds(patch->getPointer().get(), object.cast<t_gobj>(), &x, &y, &w, &h);
-
-                auto name = String::fromUTF8(objectText, len);
-                auto positionText = " (" + String(x) + ":" + String(y) + ")";
-
-                ValueTree element("Object");
-                if (type == "canvas" || type == "graph") {
-                    pd::Patch::Ptr subpatch = new pd::Patch(objectPtr, editor->pd, false);
-                    ValueTree subpatchTree = generatePatchTree(subpatch, top);
-                    element.copyPropertiesAndChildrenFrom(subpatchTree, nullptr);
-
-                    element.setProperty("Name", name, nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", canvas_isabstraction(subpatch->getPointer().get()) ? Icons::File : Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                } else {
-                    element.setProperty("Name", name.upToFirstOccurrenceOf(" ", false, false), nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                }
-
-                patchTree.appendChild(element, nullptr);
-            }
-        }
-
-        return patchTree;
-    }
-
     SafePointer<Canvas> currentCanvas;
     PluginEditor* editor;
     ValueTreeViewerComponent patchTree = ValueTreeViewerComponent("(Subpatch)");
     SearchEditor input;
+    
+    int lastGeneration = -1;
+    std::atomic<int> lastQueryId = 0;
+    ThreadPool searchThread = ThreadPool(1);
 };
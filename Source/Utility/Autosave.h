@@ -1,7 +1,174 @@
 #pragma once
+#include <map>
 #include <readerwriterqueue.h>
 #include "Dialogs/Dialogs.h"
 
+// Autosaves are appended to a journal, so saving one patch doesn't rewrite the saves of all other patches
+// Every record holds the time, path and compressed content of one patch. When the journal grows too large,
+// it's compacted to only the latest save of the most recently saved patches
+class AutosaveJournal {
+public:
+    struct Entry {
+        String path;
+        String content;
+        int64 time = 0;
+    };
+
+    static constexpr int maxEntries = 15;
+
+    // Returns the latest save of every patch in the journal, also reads the single ValueTree format of older versions
+    static std::vector<Entry> read(File const& file)
+    {
+        ScopedLock lock(journalLock);
+
+        FileInputStream istream(file);
+        if (!istream.openedOk())
+            return {};
+
+        std::vector<Entry> entries;
+
+        if (!isJournal(istream)) {
+            istream.setPosition(0);
+            auto tree = ValueTree::readFromStream(istream);
+            for (auto save : tree) {
+                MemoryOutputStream content;
+                Base64::convertFromBase64(content, save.getProperty("Patch").toString());
+                entries.push_back({ save.getProperty("Path").toString(), content.toUTF8(), static_cast<int64>(save.getProperty("LastModified")) });
+            }
+            return entries;
+        }
+
+        while (istream.getNumBytesRemaining() >= 4) {
+            auto size = istream.readInt();
+
+            // A record that was cut off while writing it, we can't read anything after it
+            if (size <= 0 || istream.getNumBytesRemaining() < size)
+                break;
+
+            MemoryBlock record;
+            istream.readIntoMemoryBlock(record, size);
+
+            MemoryInputStream recordStream(record, false);
+            Entry entry;
+            entry.time = recordStream.readInt64();
+            entry.path = recordStream.readString();
+
+            GZIPDecompressorInputStream content(recordStream);
+            entry.content = content.readEntireStreamAsString();
+
+            // Later records replace earlier ones
+            auto existing = std::find_if(entries.begin(), entries.end(), [&entry](Entry const& e) { return e.path == entry.path; });
+            if (existing != entries.end()) {
+                *existing = std::move(entry);
+            } else {
+                entries.push_back(std::move(entry));
+            }
+        }
+
+        return entries;
+    }
+
+    static void append(File const& file, Entry const& entry)
+    {
+        ScopedLock lock(journalLock);
+
+        // The first save after an update converts the old format, and we need to know how many records there are
+        if (numRecords < 0 || !isJournal(file)) {
+            auto entries = read(file);
+            entries.push_back(entry);
+            compact(file, entries);
+            return;
+        }
+
+        FileOutputStream ostream(file);
+        if (!ostream.openedOk())
+            return;
+
+        writeRecord(ostream, entry);
+        ostream.flush();
+
+        if (++numRecords > maxRecords) {
+            compact(file, read(file));
+        }
+    }
+
+private:
+    static void compact(File const& file, std::vector<Entry> entries)
+    {
+        std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) {
+            return a.time > b.time;
+        });
+
+        // Only keep the latest save of every patch, for the most recently saved patches
+        std::vector<Entry> latest;
+        for (auto& entry : entries) {
+            if (latest.size() >= maxEntries)
+                break;
+            if (std::none_of(latest.begin(), latest.end(), [&entry](Entry const& e) { return e.path == entry.path; }))
+                latest.push_back(std::move(entry));
+        }
+
+        TemporaryFile tempFile(file);
+        {
+            FileOutputStream ostream(tempFile.getFile());
+            if (!ostream.openedOk())
+                return;
+
+            ostream.writeInt(journalMagic);
+            ostream.writeInt(journalVersion);
+
+            // Oldest first, so the order of the records matches the order they were saved in
+            for (auto it = latest.rbegin(); it != latest.rend(); ++it) {
+                writeRecord(ostream, *it);
+            }
+
+            ostream.flush();
+            if (ostream.getStatus().failed())
+                return;
+        }
+
+        if (tempFile.overwriteTargetFileWithTemporary())
+            numRecords = static_cast<int>(latest.size());
+    }
+
+    static void writeRecord(OutputStream& ostream, Entry const& entry)
+    {
+        MemoryOutputStream record;
+        record.writeInt64(entry.time);
+        record.writeString(entry.path);
+        {
+            GZIPCompressorOutputStream content(record);
+            content.writeText(entry.content, false, false, nullptr);
+        }
+
+        // Write the record in one go, so a crash can only ever cut off the last record
+        MemoryOutputStream sizeAndRecord;
+        sizeAndRecord.writeInt(static_cast<int>(record.getDataSize()));
+        sizeAndRecord << record.getMemoryBlock();
+        ostream.write(sizeAndRecord.getData(), sizeAndRecord.getDataSize());
+    }
+
+    static bool isJournal(InputStream& istream)
+    {
+        return istream.getTotalLength() >= 8 && istream.readInt() == journalMagic && istream.readInt() <= journalVersion;
+    }
+
+    static bool isJournal(File const& file)
+    {
+        FileInputStream istream(file);
+        return istream.openedOk() && isJournal(istream);
+    }
+
+    static constexpr int journalMagic = 0x4A414450; // "PDAJ"
+    static constexpr int journalVersion = 1;
+
+    // Compact once the journal holds this many records
+    static constexpr int maxRecords = 64;
+
+    static inline CriticalSection journalLock;
+    static inline int numRecords = -1;
+};
+
 class Autosave : public Timer
     , public AsyncUpdater
     , public Value::Listener {
@@ -12,20 +179,25 @@ class Autosave : public Timer
     Value autosaveEnabled;
 
     PluginProcessor* pd;
-    moodycamel::ReaderWriterQueue<std::pair<String, String>> autoSaveQueue;
+    moodycamel::ReaderWriterQueue<AutosaveJournal::Entry> autoSaveQueue;
+
+    // Edit revision of every patch when it was last autosaved, keyed by canvas pointer
+    std::map<void*, uint32> savedRevisions;
+
+    // Patches are converted to text and written to the journal on this thread
+    ThreadPool journalThread { 1 };
 
 public:
     Autosave(PluginProcessor* procesor)
         : pd(procesor)
     {
-        if (!autoSaveFile.existsAsFile()) {
-            autoSaveFile.create();
-        } else {
-            FileInputStream istream(autoSaveFile);
-            autoSaveTree = ValueTree::readFromStream(istream);
-            // In case something went wrong
-            if (!autoSaveTree.isValid())
-                autoSaveTree = ValueTree("Autosave");
+        autoSaveTree = ValueTree("Autosave");
+        for (auto const& entry : AutosaveJournal::read(autoSaveFile)) {
+            ValueTree save("Save");
+            save.setProperty("Path", entry.path, nullptr);
+            save.setProperty("Patch", Base64::toBase64(entry.content), nullptr);
+            save.setProperty("LastModified", entry.time, nullptr);
+            autoSaveTree.appendChild(save, nullptr);
         }
 
         autosaveEnabled.referTo(SettingsFile::getInstance()->getPropertyAsValue("autosave_enabled"));
@@ -36,6 +208,14 @@ public:
         startTimer(1000 * getValue<int>(autosaveInterval));
     }
 
+    ~Autosave() override
+    {
+        // Let pending saves finish, they refer to our queue
+        while (journalThread.getNumJobs() > 0) {
+            Thread::sleep(1);
+        }
+    }
+
     // Call this whenever we load a file
     void checkForMoreRecentAutosave(File& patchPath, std::function<void()> callback)
     {
@@ -81,14 +261,53 @@ private:
         if (!getValue<bool>(autosaveEnabled))
             return;
 
-        pd->enqueueFunctionAsync([this]() {
-            save();
-        });
+        save();
     }
 
+    // Converts the snapshots to text and appends them to the journal
+    struct JournalJob : public ThreadPoolJob {
+        JournalJob(Autosave& a, std::vector<std::pair<String, t_binbuf*>> toSave)
+            : ThreadPoolJob("Autosave")
+            , autosave(a)
+            , snapshots(std::move(toSave))
+        {
+        }
+
+        ~JournalJob() override
+        {
+            for (auto& [path, snapshot] : snapshots) {
+                if (snapshot)
+                    binbuf_free(snapshot);
+            }
+        }
+
+        JobStatus runJob() override
+        {
+            auto time = Time::currentTimeMillis();
+            for (auto& [path, snapshot] : snapshots) {
+                AutosaveJournal::Entry entry { path, pd::Patch::canvasContentToString(snapshot), time };
+                snapshot = nullptr;
+
+                AutosaveJournal::append(autoSaveFile, entry);
+                autosave.autoSaveQueue.enqueue(std::move(entry));
+            }
+
+            autosave.triggerAsyncUpdate();
+            return jobHasFinished;
+        }
+
+        Autosave& autosave;
+        std::vector<std::pair<String, t_binbuf*>> snapshots;
+    };
+
     void save()
     {
+        std::vector<std::pair<String, t_binbuf*>> snapshots;
+
+        // Only copying the patches that were edited since the last autosave needs the lock
+        pd->lockAudioThread();
         for (auto& patch : pd->patches) {
+            patch->updateUndoRedoState();
             if (!patch->isDirty())
                 continue;
 
@@ -106,12 +325,27 @@ private:
             auto patchFile = patch->getPatchFile();
 
             // Simple way to filter out plugdata default patches which we don't want to save.
-            if (!isInternalPatch(patchFile)) {
-                autoSaveQueue.enqueue({ patchFile.getFullPathName(), patch->getCanvasContent() });
-            }
+            if (isInternalPatch(patchFile))
+                continue;
+
+            auto revision = patch->getEditRevision();
+            auto [savedRevision, isNew] = savedRevisions.try_emplace(patch->getUncheckedPointer(), revision);
+            if (!isNew && savedRevision->second == revision)
+                continue;
+
+            savedRevision->second = revision;
+            snapshots.emplace_back(patchFile.getFullPathName(), patch->snapshotCanvasContent());
+        }
+        pd->unlockAudioThread();
+
+        // Forget about patches that were closed
+        for (auto it = savedRevisions.begin(); it != savedRevisions.end();) {
+            auto isOpen = std::any_of(pd->patches.begin(), pd->patches.end(), [ptr = it->first](auto const& patch) { return patch->getUncheckedPointer() == ptr; });
+            it = isOpen ? std::next(it) : savedRevisions.erase(it);
         }
 
-        triggerAsyncUpdate();
+        if (!snapshots.empty())
+            journalThread.addJob(new JournalJob(*this, std::move(snapshots)), true);
     }
 
     bool isInternalPatch(File const& patch)
@@ -120,31 +354,24 @@ private:
         return pathName.contains("Documents/plugdata/Abstractions") || pathName.contains("Documents\\plugdata\\Abstractions") || pathName.contains("Documents/plugdata/Documentation") || pathName.contains("Documents\\plugdata\\Documentation") || pathName.contains("Documents/plugdata/Extra") || pathName.contains("Documents\\plugdata\\Extra") || patch.getParentDirectory() == File::getSpecialLocation(File::tempDirectory);
     }
 
+    // Keeps the autosave history up to date, the journal is already written by then
     void handleAsyncUpdate() override
     {
-        std::pair<String, String> pathAndContent;
-        while (autoSaveQueue.try_dequeue(pathAndContent)) {
-            auto& [path, content] = pathAndContent;
-
-            // Make sure we get current time in the correct format used by the OS for file modification time
-            auto tempFile = File::createTempFile("temp_time_test");
-            tempFile.create();
-            auto time = tempFile.getCreationTime().toMilliseconds();
-            tempFile.deleteFile();
-
-            auto existingPatch = autoSaveTree.getChildWithProperty("Path", path);
+        AutosaveJournal::Entry entry;
+        while (autoSaveQueue.try_dequeue(entry)) {
+            auto existingPatch = autoSaveTree.getChildWithProperty("Path", entry.path);
 
             if (existingPatch.isValid()) {
-                existingPatch.setProperty("Patch", Base64::toBase64(content), nullptr);
-                existingPatch.setProperty("LastModified", (int64)time, nullptr);
+                existingPatch.setProperty("Patch", Base64::toBase64(entry.content), nullptr);
+                existingPatch.setProperty("LastModified", entry.time, nullptr);
             } else {
                 ValueTree newAutoSave = ValueTree("Save");
-                newAutoSave.setProperty("Path", path, nullptr);
-                newAutoSave.setProperty("Patch", Base64::toBase64(content), nullptr);
-                newAutoSave.setProperty("LastModified", (int64)time, nullptr);
+                newAutoSave.setProperty("Path", entry.path, nullptr);
+                newAutoSave.setProperty("Patch", Base64::toBase64(entry.content), nullptr);
+                newAutoSave.setProperty("LastModified", entry.time, nullptr);
                 autoSaveTree.addChild(newAutoSave, 0, nullptr);
 
-                if (autoSaveTree.getNumChildren() > 15) {
+                if (autoSaveTree.getNumChildren() > AutosaveJournal::maxEntries) {
                     int64 oldestTime = std::numeric_limits<int64>::max();
                     int oldestIdx = -1;
                     int currentIdx = 0;
@@ -162,10 +389,6 @@ private:
                 }
             }
         }
-
-        autoSaveFile.replaceWithText("");
-        FileOutputStream ostream(autoSaveFile);
-        autoSaveTree.writeToStream(ostream);
     }
 
     friend class AutosaveHistoryComponent;
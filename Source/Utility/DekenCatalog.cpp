@@ -0,0 +1,275 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <numeric>
+
+#include "DekenCatalog.h"
+
+DekenCatalog::DekenCatalog(MemoryBlock const& data, PackageList const& extraPackages)
+{
+    // A package that's listed twice is merged into one entry
+    std::vector<std::vector<PackageInfo>> listing;
+    std::unordered_map<String, size_t> positions;
+    auto addVersion = [&listing, &positions](PackageInfo const& info) {
+        auto [position, isNew] = positions.try_emplace(info.name, listing.size());
+        if (isNew)
+            listing.emplace_back();
+        listing[position->second].push_back(info);
+    };
+
+    // Parse tree that was downloaded
+    auto tree = ValueTree::readFromData(data.getData(), data.getSize());
+
+    for (auto package : tree) {
+        auto name = package.getProperty("Name").toString();
+
+        for (auto version : package) {
+            auto author = version.getProperty("Author").toString();
+            auto timestamp = version.getProperty("Timestamp").toString();
+            auto url = version.getProperty("URL").toString();
+            auto description = version.getProperty("Description").toString();
+            auto versionNumber = version.getProperty("Version").toString();
+
+            StringArray objects;
+            for (auto object : version.getChildWithName("Objects")) {
+                objects.add(object.getProperty("Name").toString());
+            }
+
+            addVersion(PackageInfo(name, author, timestamp, url, description, versionNumber, objects));
+        }
+    }
+
+    for (auto const& package : extraPackages) {
+        addVersion(package);
+    }
+
+    for (auto const& versions : listing) {
+        addPackage(versions);
+    }
+}
+
+void DekenCatalog::addPackage(std::vector<PackageInfo> const& versions)
+{
+    if (versions.empty())
+        return;
+
+    // Only the newest version is listed and searched
+    auto const& newest = *std::min_element(versions.begin(), versions.end(), [](PackageInfo const& a, PackageInfo const& b) {
+        auto order = compareVersions(a.version, b.version);
+        return order != 0 ? order > 0 : a.timestamp > b.timestamp;
+    });
+
+    auto index = static_cast<int>(packages.size());
+    packages.push_back(newest);
+
+    auto texts = newest.objects;
+    texts.add(newest.name);
+    texts.add(newest.description);
+    texts.add(newest.author);
+    trigramIndex.add(index, texts);
+}
+
+PackageList DekenCatalog::getPackages() const
+{
+    PackageList result;
+    result.ensureStorageAllocated(static_cast<int>(packages.size()));
+    for (auto const& package : packages) {
+        result.add(package);
+    }
+
+    return result;
+}
+
+PackageList DekenCatalog::search(String const& query) const
+{
+    // Lower ranks are shown first, packages with the same rank stay in the order of the listing
+    std::vector<std::pair<int, int>> matches;
+    for (auto index : findCandidates(query)) {
+        auto const& info = packages[index];
+
+        int rank;
+        if (info.name.contains(query))
+            rank = 0;
+        else if (info.description.contains(query))
+            rank = 1;
+        else if (info.objects.contains(query))
+            rank = 2;
+        else if (info.author.contains(query))
+            rank = 3;
+        else if (std::any_of(info.objects.begin(), info.objects.end(), [&query](String const& object) { return object.contains(query); }))
+            rank = 4;
+        else
+            continue;
+
+        matches.emplace_back(rank, index);
+    }
+
+    std::sort(matches.begin(), matches.end());
+
+    PackageList result;
+    for (auto const& [rank, index] : matches) {
+        result.add(packages[index]);
+    }
+
+    return result;
+}
+
+std::vector<int> DekenCatalog::findCandidates(String const& query) const
+{
+    if (auto candidates = trigramIndex.findCandidates(query))
+        return *candidates;
+
+    // Queries shorter than a trigram need to look at every package
+    std::vector<int> all(packages.size());
+    std::iota(all.begin(), all.end(), 0);
+    return all;
+}
+
+int DekenCatalog::compareVersions(String const& first, String const& second)
+{
+    // Splits a version into numbers and words, separators are dropped
+    auto tokenize = [](String const& version) {
+        StringArray tokens;
+        String current;
+        bool currentIsNumber = false;
+
+        for (auto character : version.trimCharactersAtStart("vV")) {
+            auto isNumber = CharacterFunctions::isDigit(character);
+            auto isSeparator = !isNumber && !CharacterFunctions::isLetter(character);
+
+            if (current.isNotEmpty() && (isSeparator || isNumber != currentIsNumber)) {
+                tokens.add(current);
+                current.clear();
+            }
+
+            if (!isSeparator) {
+                current += character;
+                currentIsNumber = isNumber;
+            }
+        }
+
+        if (current.isNotEmpty())
+            tokens.add(current);
+
+        return tokens;
+    };
+
+    auto isNumber = [](String const& token) { return token.containsOnly("0123456789"); };
+
+    auto a = tokenize(first);
+    auto b = tokenize(second);
+
+    for (int i = 0; i < std::max(a.size(), b.size()); i++) {
+        // When one version runs out, a following word means the other is a pre-release of it, a number means it's newer
+        if (i >= a.size())
+            return isNumber(b[i]) ? -1 : 1;
+        if (i >= b.size())
+            return isNumber(a[i]) ? 1 : -1;
+
+        auto aIsNumber = isNumber(a[i]);
+        auto bIsNumber = isNumber(b[i]);
+
+        if (aIsNumber && bIsNumber) {
+            auto aValue = a[i].getLargeIntValue();
+            auto bValue = b[i].getLargeIntValue();
+            if (aValue != bValue)
+                return aValue < bValue ? -1 : 1;
+        } else if (aIsNumber != bIsNumber) {
+            return aIsNumber ? 1 : -1;
+        } else if (auto order = a[i].compareIgnoreCase(b[i]); order != 0) {
+            return order < 0 ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+Result DekenCatalog::fetch(URL const& url, File const& cacheFile, MemoryBlock& data, std::unique_ptr<WebInputStream>& stream)
+{
+    MemoryBlock cached;
+    String etag, lastModified;
+    auto hasCache = readCache(cacheFile, cached, etag, lastModified);
+
+    // Only ask for the listing if it changed since we cached it
+    String headers;
+    if (hasCache && etag.isNotEmpty())
+        headers << "If-None-Match: " << etag << "\r\n";
+    if (hasCache && lastModified.isNotEmpty())
+        headers << "If-Modified-Since: " << lastModified << "\r\n";
+
+    stream = std::make_unique<WebInputStream>(url, false);
+    stream->withExtraHeaders(headers).withConnectionTimeout(10000);
+
+    auto statusCode = stream->connect(nullptr) ? stream->getStatusCode() : 0;
+
+    if (statusCode == 304 && hasCache) {
+        data = std::move(cached);
+        return Result::ok();
+    }
+
+    if (statusCode == 200) {
+        MemoryBlock downloaded;
+        stream->readIntoMemoryBlock(downloaded);
+
+        if (!stream->isError() && downloaded.getSize() > 0) {
+            auto responseHeaders = stream->getResponseHeaders();
+            writeCache(cacheFile, downloaded, responseHeaders["ETag"], responseHeaders["Last-Modified"]);
+            data = std::move(downloaded);
+            return Result::ok();
+        }
+    }
+
+    // Offline, or the server had a problem: use what we have
+    if (hasCache) {
+        data = std::move(cached);
+        return Result::ok();
+    }
+
+    return Result::fail("Failed to connect to server");
+}
+
+bool DekenCatalog::readCache(File const& cacheFile, MemoryBlock& data)
+{
+    String etag, lastModified;
+    return readCache(cacheFile, data, etag, lastModified);
+}
+
+bool DekenCatalog::readCache(File const& cacheFile, MemoryBlock& data, String& etag, String& lastModified)
+{
+    FileInputStream input(cacheFile);
+    if (!input.openedOk())
+        return false;
+
+    auto cacheTree = ValueTree::readFromStream(input);
+    auto* block = cacheTree.getProperty("Data").getBinaryData();
+    if (!block || block->isEmpty())
+        return false;
+
+    data = *block;
+    etag = cacheTree.getProperty("ETag").toString();
+    lastModified = cacheTree.getProperty("LastModified").toString();
+    return true;
+}
+
+void DekenCatalog::writeCache(File const& cacheFile, MemoryBlock const& data, String const& etag, String const& lastModified)
+{
+    ValueTree cacheTree("DekenCatalog");
+    cacheTree.setProperty("ETag", etag, nullptr);
+    cacheTree.setProperty("LastModified", lastModified, nullptr);
+    cacheTree.setProperty("Data", var(data), nullptr);
+
+    // Write to a temporary file first, so an interrupted write never leaves a broken cache
+    TemporaryFile temporary(cacheFile);
+    {
+        FileOutputStream output(temporary.getFile());
+        if (!output.openedOk())
+            return;
+
+        cacheTree.writeToStream(output);
+    }
+
+    temporary.overwriteTargetFileWithTemporary();
+}
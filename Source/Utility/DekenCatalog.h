@@ -0,0 +1,83 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "Utility/Config.h"
+#include "Utility/TrigramIndex.h"
+
+// Struct with info about the deken package
+struct PackageInfo {
+    PackageInfo(String name, String author, String timestamp, String url, String description, String version, StringArray objects)
+    {
+        this->name = name;
+        this->author = author;
+        this->timestamp = timestamp;
+        this->url = url;
+        this->description = description;
+        this->version = version;
+        this->objects = objects;
+        packageId = Base64::toBase64(name + "_" + version + "_" + timestamp + "_" + author);
+    }
+
+    // fast compare by ID
+    friend bool operator==(PackageInfo const& lhs, PackageInfo const& rhs)
+    {
+        return lhs.packageId == rhs.packageId;
+    }
+
+    String name, author, timestamp, url, description, version, packageId;
+    StringArray objects;
+};
+
+// Array with package info to store the result of a search action in
+using PackageList = Array<PackageInfo>;
+
+// The deken package listing that plugdata's deken server pre-builds for every architecture
+// The listing is cached on disk and revalidated with the server's ETag, so opening the package manager usually costs a
+// single request that returns no data. Only the newest version of every package is kept. The text of every package is
+// indexed by trigram, so searches only have to look at a few candidates.
+// A catalog is never modified after it's built, so it can be searched from any thread
+class DekenCatalog {
+public:
+    DekenCatalog() = default;
+
+    // Parses the downloaded listing, extra packages that aren't on the deken server can be added to it
+    explicit DekenCatalog(MemoryBlock const& data, PackageList const& extraPackages = {});
+
+    bool isEmpty() const { return packages.empty(); }
+
+    // The newest version of every package, in the order of the listing
+    PackageList getPackages() const;
+
+    // Packages that match the query, ranked the same way the package manager always did: name matches first, then
+    // description, exact object name, author and finally partial object name matches
+    PackageList search(String const& query) const;
+
+    // Compares version strings like "v0.54.1" or "1.0-rc2" by their numeric parts, pre-releases sort before releases
+    static int compareVersions(String const& first, String const& second);
+
+    // Downloads the listing to the cache file, or revalidates the cached copy if there is one
+    // When the server can't be reached, the cached copy is used. The stream is kept so it can be cancelled
+    static Result fetch(URL const& url, File const& cacheFile, MemoryBlock& data, std::unique_ptr<WebInputStream>& stream);
+
+    // Reads the cached listing without going to the server
+    static bool readCache(File const& cacheFile, MemoryBlock& data);
+
+private:
+    void addPackage(std::vector<PackageInfo> const& versions);
+
+    // Returns the packages that contain all trigrams of the query, sorted, or all packages if the query is too short
+    std::vector<int> findCandidates(String const& query) const;
+
+    static bool readCache(File const& cacheFile, MemoryBlock& data, String& etag, String& lastModified);
+    static void writeCache(File const& cacheFile, MemoryBlock const& data, String const& etag, String const& lastModified);
+
+    std::vector<PackageInfo> packages;
+    TrigramIndex trigramIndex;
+};
@@ -23,15 +23,19 @@ For more information visit www.rabiensoftware.com
  #include <sys/inotify.h>
  #include <limits.h>
  #include <unistd.h>
+ #include <poll.h>
  #include <sys/stat.h>
  #include <sys/time.h>
+ #include <map>
+ #include <set>
+ #include <unordered_map>
 #endif
 
 #if JUCE_MAC
 class FileSystemWatcher::Impl
 {
 public:
-    Impl (FileSystemWatcher& o, File f) : owner (o), folder (f)
+    Impl (FileSystemWatcher& o, File f, bool r) : owner (o), folder (f), recursive (r)
     {
         NSString* newPath = [NSString stringWithUTF8String:folder.getFullPathName().toRawUTF8()];
 
@@ -78,6 +82,11 @@ public:
             FSEventStreamEventFlags evt = eventFlags[i];
 
             File path = String::fromUTF8 (file);
+
+            // FSEvents always watches the whole tree
+            if (! impl->recursive && path != impl->folder && path.getParentDirectory() != impl->folder)
+                continue;
+
             if (evt & kFSEventStreamEventFlagItemModified)
                 impl->owner.fileChanged (path, FileSystemEvent::fileUpdated);
             else if (evt & kFSEventStreamEventFlagItemRemoved)
@@ -91,6 +100,7 @@ public:
 
     FileSystemWatcher& owner;
     const File folder;
+    const bool recursive;
 
     NSArray* paths;
     FSEventStreamRef stream;
@@ -101,118 +111,310 @@ public:
 #ifdef JUCE_LINUX
 #define BUF_LEN (10 * (sizeof(struct inotify_event) + NAME_MAX + 1))
 
-class FileSystemWatcher::Impl : public Thread,
-                                private AsyncUpdater
+class InotifySubscriber
 {
 public:
-    struct Event
+    virtual ~InotifySubscriber() = default;
+
+    virtual File getFolder() const = 0;
+    virtual bool isRecursive() const = 0;
+    virtual void notify (const File& file, FileSystemWatcher::FileSystemEvent fsEvent) = 0;
+
+    // Whether a change to this file should be reported to this subscriber
+    bool covers (const File& file) const
     {
-        Event () {}
-        Event (Event& other) = default;
-        Event (Event&& other) = default;
+        auto folder = getFolder();
+        return file == folder || (isRecursive() ? file.isAChildOf (folder) : file.getParentDirectory() == folder);
+    }
 
-        File file;
-        FileSystemEvent fsEvent;
+    // Whether this subscriber needs a watch on this directory
+    bool needsWatch (const File& directory) const
+    {
+        auto folder = getFolder();
+        return directory == folder || (isRecursive() && directory.isAChildOf (folder));
+    }
+};
 
-        bool operator== (const Event& other) const
+// A single inotify instance and thread for every watcher in the process
+// Recursive folders are walked on the service thread, and directories that are created later get a watch as soon as
+// they appear. Non-recursive folders only get a watch on the folder itself
+class InotifyService : public Thread,
+                       private AsyncUpdater
+{
+public:
+    InotifyService() : Thread ("FileSystemWatcher")
+    {
+        fd = inotify_init1 (IN_CLOEXEC | IN_NONBLOCK);
+
+        if (fd >= 0)
+            startThread (Priority::background);
+    }
+
+    ~InotifyService() override
+    {
+        stopThread (1000);
+        cancelPendingUpdate();
+
+        if (fd >= 0)
+            close (fd);
+    }
+
+    void subscribe (InotifySubscriber* subscriber)
+    {
+        ScopedLock sl (lock);
+        subscribers.add (subscriber);
+        addWatch (subscriber->getFolder());
+
+        if (subscriber->isRecursive())
+            pendingScans.push_back (subscriber->getFolder());
+    }
+
+    void unsubscribe (InotifySubscriber* subscriber)
+    {
+        ScopedLock sl (lock);
+        subscribers.removeFirstMatchingValue (subscriber);
+
+        // Stop watching directories that no other subscriber is interested in
+        for (auto it = watches.begin(); it != watches.end();)
         {
-            return file == other.file && fsEvent == other.fsEvent;
+            if (! isWatched (it->second))
+            {
+                inotify_rm_watch (fd, it->first);
+                watchedDirectories.erase (it->second.getFullPathName());
+                it = watches.erase (it);
+            }
+            else
+            {
+                ++it;
+            }
         }
-    };
+    }
 
-    Impl (FileSystemWatcher& o, File f)
-      : Thread ("FileSystemWatcher::Impl"), owner (o), folder (f)
+private:
+    struct Event
     {
-        fd = inotify_init();
+        File file;
+        FileSystemWatcher::FileSystemEvent fsEvent;
+    };
 
-        wd = inotify_add_watch (fd,
-                                folder.getFullPathName().toRawUTF8(),
-                                IN_ATTRIB | IN_CREATE | IN_DELETE | IN_DELETE_SELF |
-                                IN_MODIFY | IN_MOVE_SELF | IN_MOVED_TO | IN_MOVED_FROM);
+    bool isWatched (const File& directory) const
+    {
+        for (auto* subscriber : subscribers)
+            if (subscriber->needsWatch (directory))
+                return true;
 
-        startThread();
+        return false;
     }
 
-    ~Impl()
+    void addWatch (const File& directory)
     {
-        shouldQuit = true;
-        signalThreadShouldExit();
-        inotify_rm_watch (fd, wd);
-        close (fd);
+        if (fd < 0 || watchedDirectories.count (directory.getFullPathName()))
+            return;
 
-        waitForThreadToExit (1000);
+        auto wd = inotify_add_watch (fd, directory.getFullPathName().toRawUTF8(),
+                                     IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_MOVE_SELF);
+
+        if (wd >= 0)
+        {
+            // A directory that was moved away and back can get its old descriptor again
+            if (auto existing = watches.find (wd); existing != watches.end())
+                watchedDirectories.erase (existing->second.getFullPathName());
+
+            watches[wd] = directory;
+            watchedDirectories[directory.getFullPathName()] = wd;
+        }
     }
 
-    void run() override
+    void removeWatch (int wd)
     {
-        char buf[BUF_LEN];
+        if (auto it = watches.find (wd); it != watches.end())
+        {
+            watchedDirectories.erase (it->second.getFullPathName());
+            watches.erase (it);
+        }
+    }
 
-        const struct inotify_event* iNotifyEvent;
-        char* ptr;
+    // Walks the folders of new recursive subscribers and new directories, without holding the lock
+    void scanPendingFolders()
+    {
+        std::vector<File> folders;
+        {
+            ScopedLock sl (lock);
+            folders = std::exchange (pendingScans, {});
+        }
 
-        while (!shouldQuit)
+        for (auto& folder : folders)
         {
-            int numRead = read (fd, buf, BUF_LEN);
+            Array<File> directories;
+            for (auto const& entry : RangedDirectoryIterator (folder, true, "*", File::findDirectories, File::FollowSymlinks::noCycles))
+            {
+                if (threadShouldExit())
+                    return;
 
-            if (numRead <= 0 || threadShouldExit())
-                break;
+                directories.add (entry.getFile());
+            }
 
-            for (ptr = buf; ptr < buf + numRead; ptr += sizeof(struct inotify_event) + iNotifyEvent->len)
-            {
-                iNotifyEvent = (const struct inotify_event*)ptr;
-                Event e;
+            // The subscriber might have gone away while we were walking
+            ScopedLock sl (lock);
+            for (auto& directory : directories)
+                if (isWatched (directory))
+                    addWatch (directory);
+        }
+    }
 
-                e.file = File {folder.getFullPathName() + '/' + iNotifyEvent->name};
+    void run() override
+    {
+        alignas (struct inotify_event) char buf[BUF_LEN];
 
-                     if (iNotifyEvent->mask & IN_CREATE)      e.fsEvent = FileSystemEvent::fileCreated;
-                else if (iNotifyEvent->mask & IN_CLOSE_WRITE) e.fsEvent = FileSystemEvent::fileUpdated;
-                else if (iNotifyEvent->mask & IN_MOVED_FROM)  e.fsEvent = FileSystemEvent::fileRenamedOldName;
-                else if (iNotifyEvent->mask & IN_MOVED_TO)    e.fsEvent = FileSystemEvent::fileRenamedNewName;
-                else if (iNotifyEvent->mask & IN_DELETE)      e.fsEvent = FileSystemEvent::fileDeleted;
+        while (! threadShouldExit())
+        {
+            scanPendingFolders();
 
-                ScopedLock sl(lock);
-                
-                bool duplicateEvent = false;
-                for (auto existing : events)
-                {
-                    if (e == existing)
-                    {
-                        duplicateEvent = true;
-                        break;
-                    }
-                }
+            pollfd pfd { fd, POLLIN, 0 };
 
-                if (! duplicateEvent)
-                    events.add (std::move (e));
-            }
+            // Wake up regularly, so we notice when we need to stop
+            if (poll (&pfd, 1, 100) <= 0)
+                continue;
+
+            auto numRead = read (fd, buf, BUF_LEN);
+            if (numRead <= 0)
+                continue;
 
             ScopedLock sl (lock);
-            if (events.size() > 0)
+
+            for (char* ptr = buf; ptr < buf + numRead;)
+            {
+                auto const* iNotifyEvent = reinterpret_cast<const struct inotify_event*> (ptr);
+                ptr += sizeof (struct inotify_event) + iNotifyEvent->len;
+                handleEvent (*iNotifyEvent);
+            }
+
+            if (! pendingEvents.empty())
                 triggerAsyncUpdate();
         }
     }
 
-    void handleAsyncUpdate() override
+    void handleEvent (const struct inotify_event& iNotifyEvent)
     {
-        if(shouldQuit) return;
+        // We lost events, let everyone know that something in their folder changed
+        if (iNotifyEvent.mask & IN_Q_OVERFLOW)
+        {
+            for (auto* subscriber : subscribers)
+                addPendingEvent ({ subscriber->getFolder(), FileSystemWatcher::fileUpdated });
+            return;
+        }
+
+        if (iNotifyEvent.mask & IN_IGNORED)
+        {
+            removeWatch (iNotifyEvent.wd);
+            return;
+        }
 
+        // The directory moved away, the new location gets its own watch if it's inside a watched folder
+        if (iNotifyEvent.mask & IN_MOVE_SELF)
+        {
+            inotify_rm_watch (fd, iNotifyEvent.wd);
+            removeWatch (iNotifyEvent.wd);
+            return;
+        }
+
+        auto it = watches.find (iNotifyEvent.wd);
+        if (it == watches.end() || iNotifyEvent.len == 0)
+            return;
+
+        Event e;
+        e.file = it->second.getChildFile (String::fromUTF8 (iNotifyEvent.name));
+
+             if (iNotifyEvent.mask & IN_CREATE)      e.fsEvent = FileSystemWatcher::fileCreated;
+        else if (iNotifyEvent.mask & IN_CLOSE_WRITE) e.fsEvent = FileSystemWatcher::fileUpdated;
+        else if (iNotifyEvent.mask & IN_MOVED_FROM)  e.fsEvent = FileSystemWatcher::fileRenamedOldName;
+        else if (iNotifyEvent.mask & IN_MOVED_TO)    e.fsEvent = FileSystemWatcher::fileRenamedNewName;
+        else if (iNotifyEvent.mask & IN_DELETE)      e.fsEvent = FileSystemWatcher::fileDeleted;
+        else return;
+
+        // Watch new directories inside recursive folders too, including anything that was created inside them before
+        // we got here
+        if ((iNotifyEvent.mask & IN_ISDIR) && (iNotifyEvent.mask & (IN_CREATE | IN_MOVED_TO)) && isWatched (e.file))
+        {
+            addWatch (e.file);
+            pendingScans.push_back (e.file);
+        }
+
+        addPendingEvent (std::move (e));
+    }
+
+    void addPendingEvent (Event e)
+    {
+        // Repeated events for the same file are only reported once per dispatch
+        if (pendingKeys.insert ({ e.file.getFullPathName(), static_cast<int> (e.fsEvent) }).second)
+            pendingEvents.push_back (std::move (e));
+    }
+
+    void handleAsyncUpdate() override
+    {
         ScopedLock sl (lock);
 
-        for (auto& e : events)
-            owner.fileChanged (e.file, e.fsEvent);
+        auto events = std::exchange (pendingEvents, {});
+        pendingKeys.clear();
 
-        events.clear();
+        // Listeners may stop watching while we're calling them
+        auto currentSubscribers = subscribers;
+
+        for (auto& e : events)
+        {
+            for (auto* subscriber : currentSubscribers)
+            {
+                if (subscriber->covers (e.file) && subscribers.contains (subscriber))
+                    subscriber->notify (e.file, e.fsEvent);
+            }
+        }
     }
 
-    std::atomic<bool> shouldQuit = false;
-    FileSystemWatcher& owner;
-    File folder;
+    int fd = -1;
 
     CriticalSection lock;
-    Array<Event> events;
+    Array<InotifySubscriber*> subscribers;
+    std::map<int, File> watches;
+    std::unordered_map<String, int> watchedDirectories;
+    std::vector<File> pendingScans;
+
+    std::vector<Event> pendingEvents;
+    std::set<std::pair<String, int>> pendingKeys;
+};
+
+class FileSystemWatcher::Impl : private InotifySubscriber
+{
+public:
+    Impl (FileSystemWatcher& o, File f, bool r) : owner (o), folder (f), recursive (r)
+    {
+        service->subscribe (this);
+    }
+
+    ~Impl() override
+    {
+        service->unsubscribe (this);
+    }
+
+    File getFolder() const override
+    {
+        return folder;
+    }
+
+    bool isRecursive() const override
+    {
+        return recursive;
+    }
+
+    void notify (const File& file, FileSystemEvent fsEvent) override
+    {
+        owner.fileChanged (file, fsEvent);
+    }
+
+    FileSystemWatcher& owner;
+    const File folder;
+    const bool recursive;
 
-    int fd;
-    int wd;
+    SharedResourcePointer<InotifyService> service;
 };
 #endif
 
@@ -232,8 +434,8 @@ public:
         }
     };
 
-    Impl (FileSystemWatcher& o, File f)
-      : Thread ("FileSystemWatcher::Impl"), owner (o), folder (f)
+    Impl (FileSystemWatcher& o, File f, bool r)
+      : Thread ("FileSystemWatcher::Impl"), owner (o), folder (f), recursive (r)
     {
         WCHAR path[_MAX_PATH] = {0};
         wcsncpy_s (path, folder.getFullPathName().toWideCharPointer(), _MAX_PATH - 1);
@@ -270,7 +472,7 @@ public:
         while (! threadShouldExit())
         {
             memset (buffer, 0, heapSize);
-            BOOL success = ReadDirectoryChangesW (folderHandle, buffer, heapSize, true,
+            BOOL success = ReadDirectoryChangesW (folderHandle, buffer, heapSize, recursive,
                 FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION,
                 &bytesOut, nullptr, nullptr);
 
@@ -342,6 +544,7 @@ public:
 
     FileSystemWatcher& owner;
     const File folder;
+    const bool recursive;
 
     CriticalSection lock;
     Array<Event> events;
@@ -355,7 +558,7 @@ public:
 class FileSystemWatcher::Impl
 {
 public:
-    Impl (FileSystemWatcher& o, File f) : owner (o), folder (f)
+    Impl (FileSystemWatcher& o, File f, bool) : owner (o), folder (f)
     {
     }
 
@@ -377,13 +580,13 @@ FileSystemWatcher::~FileSystemWatcher()
 {
 }
 
-void FileSystemWatcher::addFolder (const File& folder)
+void FileSystemWatcher::addFolder (const File& folder, bool recursive)
 {
     // You can only listen to folders that exist
     jassert (folder.isDirectory());
 
     if ( ! getWatchedFolders().contains (folder))
-        watched.add (new Impl (*this, folder));
+        watched.add (new Impl (*this, folder, recursive));
 }
 
 void FileSystemWatcher::removeFolder (const File& folder)
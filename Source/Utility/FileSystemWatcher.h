@@ -17,8 +17,12 @@ For more information visit www.rabiensoftware.com
     created, modified, deleted or renamed in the watched
     folder.
 
-    FileSystemWatcher will also recursively watch all subfolders on
-    macOS and windows and will not on Linux.
+    Folders are watched recursively unless asked otherwise.
+    On Linux, all watchers in the process share a single inotify
+    instance and thread, which also walks recursive folders.
+
+    Listeners get filesystemChanged once a burst of changes has
+    settled, and can filter which files they care about.
 
  */
 class FileSystemWatcher {
@@ -26,8 +30,8 @@ public:
     FileSystemWatcher();
     ~FileSystemWatcher();
 
-    /** Adds a folder to be watched */
-    void addFolder(File const& folder);
+    /** Adds a folder to be watched, and all of its subfolders if recursive is set */
+    void addFolder(File const& folder, bool recursive = true);
 
     /** Removes a folder from being watched */
     void removeFolder(File const& folder);
@@ -52,28 +56,70 @@ public:
     };
 
     /** Receives callbacks from the FileSystemWatcher when a file changes */
-    class Listener : public AsyncUpdater {
+    class Listener {
     public:
         virtual ~Listener() = default;
-        
-        // group changes together
-        void handleAsyncUpdate() override
-        {
-            filesystemChanged();
-        }
-        
+
         /* Called for each file that has changed and how it has changed. Use this callback
            if you need to reload a file when it's contents change */
         virtual void fileChanged(File const f, FileSystemEvent)
+        {
+            if (isInterestedIn(f))
+                debouncer.trigger();
+        }
+
+        /* Filters the files that trigger filesystemChanged */
+        virtual bool isInterestedIn(File const& f)
         {
             // By default, don't respond to hidden files (which would be .settings and .autosave)
             // If you want that to respond to hidden file changes, override this
-            if(f.isHidden() || f.getFileName().startsWith(".")) return;
-            
-            triggerAsyncUpdate();
+            return !f.isHidden() && !f.getFileName().startsWith(".");
         }
-        
+
+        /* Called once a burst of changes has settled: when nothing changed for the debounce time,
+           or after the maximum delay if changes keep coming in */
         virtual void filesystemChanged() {};
+
+        void setDebounceTime(int debounceMilliseconds, int maxDelayMilliseconds)
+        {
+            debouncer.debounceTime = debounceMilliseconds;
+            debouncer.maxDelay = maxDelayMilliseconds;
+        }
+
+    private:
+        // Groups changes together, editors that save by writing a temporary file and renaming it cause several events per save
+        class Debouncer : private Timer {
+        public:
+            explicit Debouncer(Listener& l)
+                : listener(l)
+            {
+            }
+
+            void trigger()
+            {
+                auto const now = Time::getMillisecondCounter();
+                if (!isTimerRunning())
+                    firstChangeTime = now;
+
+                auto const elapsed = static_cast<int>(now - firstChangeTime);
+                startTimer(jlimit(1, debounceTime, maxDelay - elapsed));
+            }
+
+            int debounceTime = 250;
+            int maxDelay = 1000;
+
+        private:
+            void timerCallback() override
+            {
+                stopTimer();
+                listener.filesystemChanged();
+            }
+
+            Listener& listener;
+            uint32 firstChangeTime = 0;
+        };
+
+        Debouncer debouncer { *this };
     };
 
     /** Registers a listener to be told when things happen to the text.
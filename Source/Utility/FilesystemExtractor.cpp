@@ -0,0 +1,263 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <set>
+
+#include "Utility/Config.h"
+
+#include <BinaryData.h>
+
+#include "FilesystemExtractor.h"
+
+ChainedInputStream::ChainedInputStream(std::vector<Chunk> chunksToRead)
+    : chunks(std::move(chunksToRead))
+{
+    for (auto const& [data, size] : chunks) {
+        chunkStarts.push_back(totalLength);
+        totalLength += static_cast<int64>(size);
+    }
+}
+
+bool ChainedInputStream::setPosition(int64 newPosition)
+{
+    position = jlimit<int64>(0, totalLength, newPosition);
+    return true;
+}
+
+int ChainedInputStream::read(void* destBuffer, int maxBytesToRead)
+{
+    auto* dest = static_cast<char*>(destBuffer);
+    int numRead = 0;
+
+    // Find the chunk that contains the current position
+    auto chunk = static_cast<size_t>(std::distance(chunkStarts.begin(), std::upper_bound(chunkStarts.begin(), chunkStarts.end(), position))) - 1;
+
+    while (numRead < maxBytesToRead && chunk < chunks.size()) {
+        auto const& [data, size] = chunks[chunk];
+        auto offset = static_cast<size_t>(position - chunkStarts[chunk]);
+
+        auto numToCopy = static_cast<int>(std::min<size_t>(size - offset, static_cast<size_t>(maxBytesToRead - numRead)));
+        if (numToCopy > 0) {
+            memcpy(dest + numRead, data + offset, static_cast<size_t>(numToCopy));
+            numRead += numToCopy;
+            position += numToCopy;
+        }
+
+        chunk++;
+    }
+
+    return numRead;
+}
+
+// Creates a new stream for every reader, so entries can be decompressed on multiple threads at once
+class FilesystemInputSource : public InputSource {
+public:
+    FilesystemInputSource()
+    {
+        // Binary data shouldn't be too big, then the compiler will run out of memory
+        // To prevent this, we split the binarydata into multiple files
+        int i = 0;
+        while (true) {
+            int size;
+            auto* resource = BinaryData::getNamedResource((String("Filesystem_") + String(i) + "_zip").toRawUTF8(), size);
+
+            if (!resource) {
+                break;
+            }
+
+            chunks.emplace_back(resource, static_cast<size_t>(size));
+            i++;
+        }
+    }
+
+    InputStream* createInputStream() override
+    {
+        return new ChainedInputStream(chunks);
+    }
+
+    InputStream* createInputStreamFor(String const&) override
+    {
+        return nullptr;
+    }
+
+    int64 hashCode() const override
+    {
+        return static_cast<int64>(chunks.size());
+    }
+
+private:
+    std::vector<ChainedInputStream::Chunk> chunks;
+};
+
+FilesystemExtractor::~FilesystemExtractor()
+{
+    shouldStop = true;
+    if (backgroundThread)
+        backgroundThread->stopThread(-1);
+
+    extractionPool.removeAllJobs(true, -1);
+    clearSingletonInstance();
+}
+
+std::unique_ptr<ZipFile> FilesystemExtractor::openFilesystemZip()
+{
+    return std::make_unique<ZipFile>(new FilesystemInputSource());
+}
+
+File FilesystemExtractor::getMarkerFile(File const& targetDirectory)
+{
+    return targetDirectory.getChildFile(".extracting");
+}
+
+bool FilesystemExtractor::isIncomplete(File const& targetDirectory)
+{
+    return !targetDirectory.isDirectory() || getMarkerFile(targetDirectory).existsAsFile();
+}
+
+bool FilesystemExtractor::extract(File const& targetDirectory, StringArray const& deferredDirectories, StringArray const& requiredFiles)
+{
+    if (isExtracting())
+        return false;
+
+    backgroundThread.reset();
+    deferredExtractionFinished.reset();
+
+    targetDirectory.createDirectory();
+    getMarkerFile(targetDirectory).create();
+
+    zipFile = openFilesystemZip();
+
+    std::vector<std::pair<int, String>> files;
+    std::vector<std::pair<int, String>> deferredFiles;
+    std::set<String> directories;
+
+    for (int i = 0; i < zipFile->getNumEntries(); i++) {
+        // Strip the root folder
+        auto path = zipFile->getEntry(i)->filename.replaceCharacter('\\', '/').fromFirstOccurrenceOf("/", false, false);
+        if (path.isEmpty())
+            continue;
+
+        if (path.endsWithChar('/')) {
+            directories.insert(path.dropLastCharacters(1));
+            continue;
+        }
+
+        directories.insert(path.upToLastOccurrenceOf("/", false, false));
+
+        auto isDeferred = !requiredFiles.contains(path) && std::any_of(deferredDirectories.begin(), deferredDirectories.end(), [&path](String const& directory) {
+            return path.startsWith(directory + "/");
+        });
+
+        (isDeferred ? deferredFiles : files).emplace_back(i, path);
+    }
+
+    // Create all directories up front, so the workers never race to create the same parent
+    for (auto const& directory : directories) {
+        targetDirectory.getChildFile(directory).createDirectory();
+    }
+
+    auto numFailed = extractEntries(*zipFile, files, targetDirectory);
+
+    if (deferredFiles.empty()) {
+        if (numFailed == 0)
+            getMarkerFile(targetDirectory).deleteFile();
+        zipFile.reset();
+        deferredExtractionFinished.signal();
+        return numFailed == 0;
+    }
+
+    class BackgroundExtraction : public Thread {
+    public:
+        BackgroundExtraction(FilesystemExtractor& e, std::vector<std::pair<int, String>> entries, File target, bool succeeded)
+            : Thread("Filesystem Extraction")
+            , extractor(e)
+            , deferredFiles(std::move(entries))
+            , targetDirectory(std::move(target))
+            , hasSucceeded(succeeded)
+        {
+        }
+
+        void run() override
+        {
+            auto numFailed = extractor.extractEntries(*extractor.zipFile, deferredFiles, targetDirectory);
+
+            if (hasSucceeded && numFailed == 0 && !threadShouldExit())
+                getMarkerFile(targetDirectory).deleteFile();
+
+            extractor.deferredExtractionFinished.signal();
+        }
+
+        FilesystemExtractor& extractor;
+        std::vector<std::pair<int, String>> deferredFiles;
+        File targetDirectory;
+        bool hasSucceeded;
+    };
+
+    backgroundThread = std::make_unique<BackgroundExtraction>(*this, std::move(deferredFiles), targetDirectory, numFailed == 0);
+    backgroundThread->startThread(Thread::Priority::background);
+
+    return numFailed == 0;
+}
+
+bool FilesystemExtractor::waitForDeferredExtraction(int timeoutMilliseconds)
+{
+    if (!isExtracting())
+        return true;
+
+    return deferredExtractionFinished.wait(timeoutMilliseconds);
+}
+
+int FilesystemExtractor::extractEntries(ZipFile& zip, std::vector<std::pair<int, String>> const& entries, File const& targetDirectory)
+{
+    std::atomic<size_t> nextEntry = 0;
+    std::atomic<int> numFailed = 0;
+    std::atomic<int> numWorkersLeft = extractionPool.getNumThreads();
+    WaitableEvent finished;
+
+    // Every worker takes the next entry until all of them are done
+    for (int i = 0; i < extractionPool.getNumThreads(); i++) {
+        extractionPool.addJob([&]() {
+            size_t index;
+            while (!shouldStop && (index = nextEntry++) < entries.size()) {
+                auto const& [entry, path] = entries[index];
+                if (!extractEntry(zip, entry, targetDirectory.getChildFile(path)))
+                    numFailed++;
+            }
+
+            if (--numWorkersLeft == 0)
+                finished.signal();
+        });
+    }
+
+    finished.wait();
+    return numFailed;
+}
+
+bool FilesystemExtractor::extractEntry(ZipFile& zip, int index, File const& target)
+{
+    std::unique_ptr<InputStream> in(zip.createStreamForEntry(index));
+    if (!in)
+        return false;
+
+    {
+        FileOutputStream out(target);
+        if (!out.openedOk())
+            return false;
+
+        out.setPosition(0);
+        out.truncate();
+        out.writeFromInputStream(*in, -1);
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    target.setLastModificationTime(zip.getEntry(index)->fileTime);
+    return true;
+}
+
+JUCE_IMPLEMENT_SINGLETON(FilesystemExtractor)
@@ -0,0 +1,68 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "Utility/Config.h"
+
+// Reads a sequence of memory blocks as if they were one stream, without copying them together
+class ChainedInputStream : public InputStream {
+public:
+    using Chunk = std::pair<char const*, size_t>;
+
+    explicit ChainedInputStream(std::vector<Chunk> chunksToRead);
+
+    int64 getTotalLength() override { return totalLength; }
+    bool isExhausted() override { return position >= totalLength; }
+    int64 getPosition() override { return position; }
+    bool setPosition(int64 newPosition) override;
+    int read(void* destBuffer, int maxBytesToRead) override;
+
+private:
+    std::vector<Chunk> chunks;
+    std::vector<int64> chunkStarts;
+    int64 totalLength = 0;
+    int64 position = 0;
+};
+
+// Extracts the filesystem zip that is split over the Filesystem_N_zip BinaryData chunks
+// Entries are extracted on all cores. Large directories that aren't needed to load patches can be deferred: those are
+// extracted in the background, and anything that needs them can wait for them with waitForDeferredExtraction.
+// A marker file in the target directory is only removed once everything is extracted, so an interrupted
+// extraction is picked up again on the next launch
+class FilesystemExtractor : public DeletedAtShutdown {
+public:
+    ~FilesystemExtractor() override;
+
+    // The zip contains a single root folder, its contents are extracted into targetDirectory
+    // Files in requiredFiles are always extracted right away, even if they're inside a deferred directory
+    bool extract(File const& targetDirectory, StringArray const& deferredDirectories, StringArray const& requiredFiles = {});
+
+    // Returns true if the target directory was never completely extracted
+    static bool isIncomplete(File const& targetDirectory);
+
+    bool isExtracting() const { return backgroundThread != nullptr && backgroundThread->isThreadRunning(); }
+
+    // Blocks until the deferred directories are extracted, returns false on timeout
+    bool waitForDeferredExtraction(int timeoutMilliseconds = -1);
+
+    JUCE_DECLARE_SINGLETON(FilesystemExtractor, false)
+
+private:
+    static std::unique_ptr<ZipFile> openFilesystemZip();
+    static File getMarkerFile(File const& targetDirectory);
+
+    // Extracts the given entries in parallel, returns the number of entries that failed
+    int extractEntries(ZipFile& zip, std::vector<std::pair<int, String>> const& entries, File const& targetDirectory);
+    static bool extractEntry(ZipFile& zip, int index, File const& target);
+
+    std::unique_ptr<ZipFile> zipFile;
+    std::unique_ptr<Thread> backgroundThread;
+    WaitableEvent deferredExtractionFinished { true };
+    std::atomic<bool> shouldStop = false;
+
+    ThreadPool extractionPool { std::max(1, SystemStats::getNumCpus()) };
+};
@@ -0,0 +1,120 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "FrameScheduler.h"
+
+FrameTimer::~FrameTimer()
+{
+    stopFrameTimer();
+}
+
+void FrameTimer::startFrameTimer(int intervalMs)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    interval = jmax(1, intervalMs);
+    nextCallbackTime = Time::getMillisecondCounterHiRes() + interval;
+
+    if (!running) {
+        running = true;
+        FrameScheduler::getInstance()->addSubscriber(this);
+    }
+}
+
+void FrameTimer::startFrameTimerHz(int hz)
+{
+    if (hz > 0)
+        startFrameTimer(1000 / hz);
+    else
+        stopFrameTimer();
+}
+
+void FrameTimer::stopFrameTimer()
+{
+    if (!running)
+        return;
+
+    running = false;
+
+    if (auto* scheduler = FrameScheduler::getInstanceWithoutCreating())
+        scheduler->removeSubscriber(this);
+}
+
+FrameScheduler::~FrameScheduler()
+{
+    for (auto* subscriber : subscribers) {
+        if (subscriber)
+            subscriber->running = false;
+    }
+
+    clearSingletonInstance();
+}
+
+void FrameScheduler::addSubscriber(FrameTimer* subscriber)
+{
+    subscribers.add(subscriber);
+
+    if (!isTimerRunning())
+        startTimerHz(frameRate);
+}
+
+void FrameScheduler::removeSubscriber(FrameTimer* subscriber)
+{
+    // Don't modify the array while we're iterating over it, empty slots are cleaned up after the frame
+    if (isDispatching) {
+        auto index = subscribers.indexOf(subscriber);
+        if (index >= 0)
+            subscribers.set(index, nullptr);
+        return;
+    }
+
+    subscribers.removeFirstMatchingValue(subscriber);
+
+    if (subscribers.isEmpty())
+        stopTimer();
+}
+
+void FrameScheduler::timerCallback()
+{
+    auto const frameStart = Time::getMillisecondCounterHiRes();
+    auto const numSubscribers = subscribers.size();
+
+    isDispatching = true;
+
+    for (int i = 0; i < numSubscribers; i++) {
+        auto const index = (firstSubscriber + i) % numSubscribers;
+        auto* subscriber = subscribers[index];
+
+        if (!subscriber || frameStart < subscriber->nextCallbackTime)
+            continue;
+
+        // Out of time for this frame: continue with this subscriber on the next frame
+        if (Time::getMillisecondCounterHiRes() - frameStart > frameBudgetMs) {
+            firstSubscriber = index;
+            break;
+        }
+
+        // Schedule the next callback before calling, so the callback can restart or stop the timer
+        subscriber->nextCallbackTime += subscriber->interval;
+        if (subscriber->nextCallbackTime <= frameStart)
+            subscriber->nextCallbackTime = frameStart + subscriber->interval;
+
+        if (subscriber->isFrameTimerVisible())
+            subscriber->frameTimerCallback();
+    }
+
+    isDispatching = false;
+
+    subscribers.removeAllInstancesOf(nullptr);
+
+    if (firstSubscriber >= subscribers.size())
+        firstSubscriber = 0;
+
+    if (subscribers.isEmpty())
+        stopTimer();
+}
+
+JUCE_IMPLEMENT_SINGLETON(FrameScheduler)
@@ -0,0 +1,64 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+
+// Replacement for juce::Timer for objects that need periodic GUI updates
+// Instead of running a timer per object, all FrameTimers are serviced by the FrameScheduler,
+// which batches them into a single frame callback, limits the time spent per frame,
+// and skips subscribers that are not visible
+class FrameTimer {
+public:
+    virtual ~FrameTimer();
+
+    void startFrameTimer(int intervalMs);
+    void startFrameTimerHz(int hz);
+    void stopFrameTimer();
+
+    bool isFrameTimerRunning() const { return running; }
+
+    virtual void frameTimerCallback() = 0;
+
+    // Override this to skip callbacks while the subscriber is hidden or scrolled out of view
+    virtual bool isFrameTimerVisible() { return true; }
+
+private:
+    double interval = 0.0;
+    double nextCallbackTime = 0.0;
+    bool running = false;
+
+    friend class FrameScheduler;
+};
+
+class FrameScheduler : private Timer
+    , public DeletedAtShutdown {
+public:
+    ~FrameScheduler() override;
+
+    // Number of frames per second the scheduler runs at
+    static constexpr int frameRate = 60;
+
+    // Maximum time we spend servicing subscribers per frame
+    // When we exceed this, the remaining subscribers will be serviced first on the next frame
+    static constexpr double frameBudgetMs = 6.0;
+
+    JUCE_DECLARE_SINGLETON(FrameScheduler, false)
+
+private:
+    void addSubscriber(FrameTimer* subscriber);
+    void removeSubscriber(FrameTimer* subscriber);
+
+    void timerCallback() override;
+
+    Array<FrameTimer*> subscribers;
+    int firstSubscriber = 0;
+    bool isDispatching = false;
+
+    friend class FrameTimer;
+};
@@ -0,0 +1,142 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Cached min/max mipmap over a buffer of samples
+// Level 0 stores the minimum and maximum of every block of baseBlockSize samples, and every following level
+// combines two blocks of the level below. This allows us to get the min/max of the buffer for each pixel
+// in O(pixels), no matter how large the buffer is, without losing peaks like linear interpolation would.
+class MinMaxPyramid {
+public:
+    // Rebuilds the whole pyramid
+    void build(float const* data, int size)
+    {
+        numSamples = std::max(size, 0);
+        levels.clear();
+
+        int numBlocks = (numSamples + baseBlockSize - 1) / baseBlockSize;
+        while (numBlocks > 1) {
+            levels.emplace_back(numBlocks);
+            numBlocks = (numBlocks + 1) / 2;
+        }
+
+        update(data, size, 0, size);
+    }
+
+    // Updates the pyramid after the samples in the range [start, end) have changed
+    void update(float const* data, int size, int start, int end)
+    {
+        if (size != numSamples) {
+            build(data, size);
+            return;
+        }
+
+        start = std::clamp(start, 0, numSamples);
+        end = std::clamp(end, start, numSamples);
+
+        if (levels.empty() || start == end)
+            return;
+
+        int firstBlock = start / baseBlockSize;
+        int lastBlock = (end - 1) / baseBlockSize;
+
+        for (int block = firstBlock; block <= lastBlock; block++) {
+            auto const blockStart = block * baseBlockSize;
+            auto const blockSize = std::min(baseBlockSize, numSamples - blockStart);
+            levels[0][block] = FloatVectorOperations::findMinAndMax(data + blockStart, blockSize);
+        }
+
+        for (int level = 1; level < levels.size(); level++) {
+            auto const& below = levels[level - 1];
+            firstBlock /= 2;
+            lastBlock /= 2;
+
+            for (int block = firstBlock; block <= lastBlock; block++) {
+                auto range = below[block * 2];
+                if (block * 2 + 1 < below.size())
+                    range = range.getUnionWith(below[block * 2 + 1]);
+
+                levels[level][block] = range;
+            }
+        }
+    }
+
+    // Gets the minimum and maximum value of the samples that fall within each pixel
+    void getMinMax(float const* data, int numPixels, std::vector<Range<float>>& output) const
+    {
+        output.resize(std::max(numPixels, 0));
+
+        if (numPixels <= 0 || numSamples <= 0)
+            return;
+
+        // Not enough samples per pixel to make use of the pyramid
+        auto const usePyramid = numSamples / numPixels >= baseBlockSize * 2;
+
+        for (int px = 0; px < numPixels; px++) {
+            auto const start = static_cast<int>(static_cast<int64>(px) * numSamples / numPixels);
+            auto const end = std::max(start + 1, static_cast<int>(static_cast<int64>(px + 1) * numSamples / numPixels));
+
+            output[px] = usePyramid ? getMinMax(data, start, end) : FloatVectorOperations::findMinAndMax(data + start, end - start);
+        }
+    }
+
+    // Gets the minimum and maximum of exactly the samples in [start, end)
+    // The samples outside of whole base blocks are read directly, the blocks in between are covered by at most
+    // two blocks per level, like a segment tree query
+    Range<float> getMinMax(float const* data, int start, int end) const
+    {
+        start = std::clamp(start, 0, numSamples);
+        end = std::clamp(end, start, numSamples);
+
+        int firstBlock = (start + baseBlockSize - 1) / baseBlockSize;
+        int endBlock = end / baseBlockSize;
+        if (levels.empty() || firstBlock >= endBlock)
+            return FloatVectorOperations::findMinAndMax(data + start, end - start);
+
+        auto range = levels[0][firstBlock];
+        auto addRange = [&range](Range<float> other) {
+            range = range.getUnionWith(other);
+        };
+
+        if (auto const headEnd = firstBlock * baseBlockSize; headEnd > start)
+            addRange(FloatVectorOperations::findMinAndMax(data + start, headEnd - start));
+        if (auto const tailStart = endBlock * baseBlockSize; end > tailStart)
+            addRange(FloatVectorOperations::findMinAndMax(data + tailStart, end - tailStart));
+
+        for (int level = 0; firstBlock < endBlock; level++) {
+            auto const& blocks = levels[level];
+
+            // The top level isn't combined any further
+            if (level == static_cast<int>(levels.size()) - 1) {
+                for (int block = firstBlock; block < endBlock; block++)
+                    addRange(blocks[block]);
+                break;
+            }
+
+            if (firstBlock & 1)
+                addRange(blocks[firstBlock++]);
+            if (endBlock & 1)
+                addRange(blocks[--endBlock]);
+
+            firstBlock /= 2;
+            endBlock /= 2;
+        }
+
+        return range;
+    }
+
+    int getNumSamples() const
+    {
+        return numSamples;
+    }
+
+private:
+    static constexpr int baseBlockSize = 16;
+
+    std::vector<std::vector<Range<float>>> levels;
+    int numSamples = 0;
+};
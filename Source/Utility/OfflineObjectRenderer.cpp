@@ -26,25 +26,45 @@ OfflineObjectRenderer::OfflineObjectRenderer(pd::Instance* instance)
     auto const* file = filename.toRawUTF8();
 
     offlineCnv = static_cast<t_canvas*>(pd::Interface::createCanvas(file, dir));
+
+    loadCache();
 }
 
-OfflineObjectRenderer::~OfflineObjectRenderer() = default;
+OfflineObjectRenderer::~OfflineObjectRenderer()
+{
+    saveCache();
+}
 
 OfflineObjectRenderer* OfflineObjectRenderer::findParentOfflineObjectRendererFor(Component* childComponent)
 {
     return childComponent != nullptr ? &childComponent->findParentComponentOfClass<PluginEditor>()->offlineRenderer : nullptr;
 }
 
+String OfflineObjectRenderer::getPatchHash(String const& patch)
+{
+    return SHA256(patch.getCharPointer()).toHexString();
+}
+
 ImageWithOffset OfflineObjectRenderer::patchToMaskedImage(String const& patch, float scale, bool makeInvalidImage)
 {
-    auto image = patchToTempImage(patch, scale);
+    auto backgroundColour = LookAndFeel::getDefaultLookAndFeel().findColour(PlugDataColour::objectSelectedOutlineColourId).withAlpha(0.3f);
+
+    checkLibraryState();
+
+    auto const patchHash = getPatchHash(patch);
+    auto const imageKey = patchHash + "_" + String(scale, 2) + "_" + backgroundColour.toString() + (makeInvalidImage ? "_invalid" : "");
+    if (auto cached = imageCache.find(imageKey); cached != imageCache.end()) {
+        recentlyUsedImages.splice(recentlyUsedImages.begin(), recentlyUsedImages, cached->second.position);
+        return cached->second.image;
+    }
+
+    auto image = patchToTempImage(getPatchInfo(patch, patchHash), scale);
     auto width = image.image.getWidth();
     auto height = image.image.getHeight();
     auto output = Image(Image::ARGB, width, height, true);
 
     Graphics g(output);
     g.reduceClipRegion(image.image, AffineTransform());
-    auto backgroundColour = LookAndFeel::getDefaultLookAndFeel().findColour(PlugDataColour::objectSelectedOutlineColourId).withAlpha(0.3f);
     g.fillAll(backgroundColour);
 
     if (makeInvalidImage) {
@@ -60,18 +80,41 @@ ImageWithOffset OfflineObjectRenderer::patchToMaskedImage(String const& patch, f
         g.addTransform(rotate.inverted());
     }
 
-    return ImageWithOffset(output, image.offset);
+    while (imageCache.size() >= maxCachedImages) {
+        imageCache.erase(recentlyUsedImages.back());
+        recentlyUsedImages.pop_back();
+    }
+
+    auto result = ImageWithOffset(output, image.offset);
+    recentlyUsedImages.push_front(imageKey);
+    imageCache.emplace(imageKey, CachedImage { result, recentlyUsedImages.begin() });
+    return result;
 }
 
-ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, float scale)
+ImageWithOffset OfflineObjectRenderer::patchToTempImage(PatchInfo const& info, float scale)
 {
-    static std::unordered_map<String, ImageWithOffset> patchImageCache;
+    auto size = Point<int>(info.totalSize.getWidth(), info.totalSize.getHeight());
+    Image image(Image::ARGB, info.totalSize.getWidth() * scale, info.totalSize.getHeight() * scale, true);
+    Graphics g(image);
+    g.addTransform(AffineTransform::scale(scale));
+    g.setColour(Colours::white);
+    for (auto& rect : info.objectRects) {
+        g.fillRoundedRectangle(rect.toFloat(), 5.0f);
+    }
 
-    auto const patchSHA256 = SHA256(patch.getCharPointer()).toHexString();
-    if (patchImageCache.contains(patchSHA256)) {
-        return patchImageCache[patchSHA256];
+    return ImageWithOffset(image, size);
+}
+
+OfflineObjectRenderer::PatchInfo const& OfflineObjectRenderer::getPatchInfo(String const& patch, String const& patchHash)
+{
+    checkLibraryState();
+
+    if (auto cached = patchInfoCache.find(patchHash); cached != patchInfoCache.end()) {
+        return cached->second;
     }
 
+    PatchInfo info;
+
     pd->setThis();
 
     sys_lock();
@@ -79,12 +122,22 @@ ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, flo
 
     canvas_create_editor(offlineCnv);
 
-    objectRects.clear();
-    totalSize.setBounds(0, 0, 0, 0);
     int obj_x, obj_y, obj_w, obj_h;
     auto rect = Rectangle<int>();
     pd::Interface::paste(offlineCnv, stripConnections(patch).toRawUTF8());
 
+    // The iolets are taken from the first object, for patches that consist of a single object
+    if (auto* firstObject = pd::Interface::checkObject(offlineCnv->gl_list)) {
+        int numIn = pd::Interface::numInlets(firstObject);
+        int numOut = pd::Interface::numOutlets(firstObject);
+        for (int i = 0; i < numIn; i++) {
+            info.inlets.push_back(pd::Interface::isSignalInlet(firstObject, i));
+        }
+        for (int i = 0; i < numOut; i++) {
+            info.outlets.push_back(pd::Interface::isSignalOutlet(firstObject, i));
+        }
+    }
+
     // traverse the linked list of objects, asking PD the object size each time
     auto object = offlineCnv->gl_list;
     while (object) {
@@ -96,8 +149,8 @@ ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, flo
         rect.setBounds(obj_x, obj_y, maxSize, obj_h);
 
         // put the object bounds into the rect list, and also calculate the total size of all objects
-        objectRects.add(rect);
-        totalSize = totalSize.getUnion(rect);
+        info.objectRects.add(rect);
+        info.totalSize = info.totalSize.getUnion(rect);
 
         // save the pointer to the next object
         auto nextObject = object->g_next;
@@ -111,55 +164,141 @@ ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, flo
     sys_unlock();
 
     // apply the top left offset to all rects
-    for (auto& rect : objectRects) {
-        rect.translate(-totalSize.getX(), -totalSize.getY());
-    }
-    auto size = Point<int>(totalSize.getWidth(), totalSize.getHeight());
-    Image image(Image::ARGB, totalSize.getWidth() * scale, totalSize.getHeight() * scale, true);
-    Graphics g(image);
-    g.addTransform(AffineTransform::scale(scale));
-    g.setColour(Colours::white);
-    for (auto& rect : objectRects) {
-        g.fillRoundedRectangle(rect.toFloat(), 5.0f);
+    for (auto& objectRect : info.objectRects) {
+        objectRect.translate(-info.totalSize.getX(), -info.totalSize.getY());
     }
 
-    auto output = ImageWithOffset(image, size);
-    patchImageCache.emplace(patchSHA256, output);
-    return output;
+    cacheChanged = true;
+    return patchInfoCache.emplace(patchHash, std::move(info)).first->second;
 }
 
 bool OfflineObjectRenderer::checkIfPatchIsValid(String const& patch)
 {
-    static std::unordered_map<String, bool> patchValidCache;
+    // if we can create more than 1 valid object, assume the patch is valid
+    return !getPatchInfo(patch, getPatchHash(patch)).objectRects.isEmpty();
+}
 
-    auto const patchSHA256 = SHA256(patch.getCharPointer()).toHexString();
-    if (patchValidCache.contains(patchSHA256)) {
-        return patchValidCache[patchSHA256];
+std::pair<std::vector<bool>, std::vector<bool>> OfflineObjectRenderer::countIolets(String const& patch)
+{
+    auto const& info = getPatchInfo(patch, getPatchHash(patch));
+    return { info.inlets, info.outlets };
+}
+
+void OfflineObjectRenderer::pregenerate(String const& patch)
+{
+    pregenerationQueue.addIfNotAlreadyThere(patch);
+    if (!isTimerRunning())
+        startTimer(50);
+}
+
+void OfflineObjectRenderer::timerCallback()
+{
+    // Only spend a small part of each timer tick on this, so we never make the GUI stutter
+    auto const startTime = Time::getMillisecondCounterHiRes();
+    while (!pregenerationQueue.isEmpty() && Time::getMillisecondCounterHiRes() - startTime < pregenerationBudgetMs) {
+        auto patch = pregenerationQueue[0];
+        pregenerationQueue.remove(0);
+
+        // Scale used by ObjectDragAndDrop
+        patchToMaskedImage(patch, 3.0f);
+        patchToMaskedImage(patch, 3.0f, true);
     }
 
-    pd->setThis();
+    if (pregenerationQueue.isEmpty()) {
+        stopTimer();
+        saveCache();
+    }
+}
 
-    sys_lock();
-    pd->muteConsole(true);
+String OfflineObjectRenderer::getLibraryState() const
+{
+    if (auto* processor = dynamic_cast<PluginProcessor*>(pd); processor && processor->objectLibrary)
+        return processor->objectLibrary->getStateKey();
 
-    bool isValid = false;
-    pd::Interface::paste(offlineCnv, stripConnections(patch).toRawUTF8());
+    return ProjectInfo::versionString;
+}
 
-    // if we can create more than 1 valid object, assume the patch is valid
-    auto object = offlineCnv->gl_list;
-    while (object) {
-        isValid = true;
+void OfflineObjectRenderer::checkLibraryState()
+{
+    // Empty until the library has built its object list
+    auto currentState = getLibraryState();
+    if (currentState.isEmpty() || currentState == libraryState)
+        return;
+
+    libraryState = currentState;
+    patchInfoCache.clear();
+    imageCache.clear();
+    recentlyUsedImages.clear();
+    cacheChanged = true;
+}
 
-        auto nextObject = object->g_next;
-        pd::Interface::removeObjects(offlineCnv, { object });
-        object = nextObject;
+void OfflineObjectRenderer::loadCache()
+{
+    FileInputStream input(cacheFile);
+    if (!input.openedOk())
+        return;
+
+    auto cacheTree = ValueTree::readFromStream(input);
+    if (!cacheTree.hasType("ObjectPreviews"))
+        return;
+
+    // Checked against the current library state on first use, when the abstraction scan has likely finished
+    libraryState = cacheTree.getProperty("LibraryState").toString();
+
+    for (auto patchTree : cacheTree) {
+        PatchInfo info;
+
+        auto rects = StringArray::fromTokens(patchTree.getProperty("Rects").toString(), false);
+        for (int i = 0; i + 3 < rects.size(); i += 4) {
+            info.objectRects.add({ rects[i].getIntValue(), rects[i + 1].getIntValue(), rects[i + 2].getIntValue(), rects[i + 3].getIntValue() });
+        }
+        for (auto c : patchTree.getProperty("Inlets").toString()) {
+            info.inlets.push_back(c == '1');
+        }
+        for (auto c : patchTree.getProperty("Outlets").toString()) {
+            info.outlets.push_back(c == '1');
+        }
+        info.totalSize = { 0, 0, static_cast<int>(patchTree.getProperty("Width")), static_cast<int>(patchTree.getProperty("Height")) };
+
+        patchInfoCache.emplace(patchTree.getProperty("Hash").toString(), std::move(info));
     }
+}
 
-    pd->muteConsole(false);
-    sys_unlock();
+void OfflineObjectRenderer::saveCache()
+{
+    if (!cacheChanged)
+        return;
+
+    ValueTree cacheTree("ObjectPreviews");
+    cacheTree.setProperty("LibraryState", libraryState, nullptr);
+    for (auto const& [hash, info] : patchInfoCache) {
+        StringArray rects;
+        for (auto const& rect : info.objectRects) {
+            rects.add(rect.toString());
+        }
+
+        String inlets, outlets;
+        for (auto isSignal : info.inlets)
+            inlets << (isSignal ? "1" : "0");
+        for (auto isSignal : info.outlets)
+            outlets << (isSignal ? "1" : "0");
+
+        ValueTree patchTree("Patch");
+        patchTree.setProperty("Hash", hash, nullptr);
+        patchTree.setProperty("Rects", rects.joinIntoString(" "), nullptr);
+        patchTree.setProperty("Inlets", inlets, nullptr);
+        patchTree.setProperty("Outlets", outlets, nullptr);
+        patchTree.setProperty("Width", info.totalSize.getWidth(), nullptr);
+        patchTree.setProperty("Height", info.totalSize.getHeight(), nullptr);
+        cacheTree.appendChild(patchTree, nullptr);
+    }
 
-    patchValidCache.emplace(patchSHA256, isValid);
-    return isValid;
+    cacheFile.deleteFile();
+    FileOutputStream output(cacheFile);
+    if (output.openedOk()) {
+        cacheTree.writeToStream(output);
+        cacheChanged = false;
+    }
 }
 
 // Remove all connections from the PD patch, so that it can't activate loadbangs etc
@@ -180,41 +319,3 @@ String OfflineObjectRenderer::stripConnections(String const& patch)
 
     return strippedPatch;
 }
-
-std::pair<std::vector<bool>, std::vector<bool>> OfflineObjectRenderer::countIolets(String const& patch)
-{
-    static std::unordered_map<String, std::pair<std::vector<bool>, std::vector<bool>>> patchIoletCache;
-
-    auto const patchSHA256 = SHA256(patch.getCharPointer()).toHexString();
-    if (patchIoletCache.contains(patchSHA256)) {
-        return patchIoletCache[patchSHA256];
-    }
-
-    std::vector<bool> inlets;
-    std::vector<bool> outlets;
-    pd->setThis();
-
-    sys_lock();
-    pd->muteConsole(true);
-    pd::Interface::paste(offlineCnv, stripConnections(patch).toRawUTF8());
-
-    if (auto* object = reinterpret_cast<t_object*>(offlineCnv->gl_list)) {
-        int numIn = pd::Interface::numInlets(object);
-        int numOut = pd::Interface::numOutlets(object);
-        for (int i = 0; i < numIn; i++) {
-            inlets.push_back(pd::Interface::isSignalInlet(object, i));
-        }
-        for (int i = 0; i < numOut; i++) {
-            outlets.push_back(pd::Interface::isSignalOutlet(object, i));
-        }
-    }
-
-    glist_clear(offlineCnv);
-
-    pd->muteConsole(false);
-    sys_unlock();
-
-    auto output = std::make_pair(inlets, outlets);
-    patchIoletCache.emplace(patchSHA256, output);
-    return output;
-}
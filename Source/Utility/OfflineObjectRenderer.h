@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <list>
+#include <unordered_map>
+
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "Utility/Config.h"
 #include "Pd/Instance.h"
@@ -21,7 +24,12 @@ public:
     Point<int> offset;
 };
 
-class OfflineObjectRenderer {
+// Renders previews of patches for drag-and-drop by instantiating them in an offline canvas
+// Since instantiating objects is slow, the measured object bounds and iolets are cached in memory and on disk,
+// and the rendered images are cached in memory per scale and theme colour
+// How a patch instantiates depends on the loaded externals and abstractions, so both caches are tied to the
+// library state and thrown away when it changes
+class OfflineObjectRenderer : private Timer {
 public:
     OfflineObjectRenderer(pd::Instance* pd);
     virtual ~OfflineObjectRenderer();
@@ -34,13 +42,52 @@ public:
 
     std::pair<std::vector<bool>, std::vector<bool>> countIolets(String const& patch);
 
+    // Queue a patch to have its preview generated while idle, so it's ready when the user starts dragging it
+    void pregenerate(String const& patch);
+
 private:
+    struct PatchInfo {
+        Array<Rectangle<int>> objectRects;
+        Rectangle<int> totalSize;
+        std::vector<bool> inlets;
+        std::vector<bool> outlets;
+    };
+
+    static String getPatchHash(String const& patch);
+
+    PatchInfo const& getPatchInfo(String const& patch, String const& patchHash);
+
     String stripConnections(String const& patch);
 
-    ImageWithOffset patchToTempImage(String const& patch, float scale);
+    ImageWithOffset patchToTempImage(PatchInfo const& info, float scale);
+
+    // Clears the caches if the library changed since they were filled
+    void checkLibraryState();
+    String getLibraryState() const;
+
+    void loadCache();
+    void saveCache();
+
+    void timerCallback() override;
+
+    static constexpr int maxCachedImages = 256;
+    static constexpr double pregenerationBudgetMs = 4.0;
+
+    File const cacheFile = ProjectInfo::versionDataDir.getChildFile(".object_previews");
+    std::unordered_map<String, PatchInfo> patchInfoCache;
+    String libraryState;
+    bool cacheChanged = false;
+
+    struct CachedImage {
+        ImageWithOffset image;
+        std::list<String>::iterator position;
+    };
+
+    std::list<String> recentlyUsedImages; // Most recently used first
+    std::unordered_map<String, CachedImage> imageCache;
+
+    StringArray pregenerationQueue;
 
-    Array<Rectangle<int>> objectRects;
-    Rectangle<int> totalSize;
     t_glist* offlineCnv = nullptr;
     pd::Instance* pd;
 };
@@ -0,0 +1,321 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <m_pd.h>
+#include <m_imp.h>
+#include <g_canvas.h>
+#include <g_all_guis.h>
+
+#include "PatchSearchIndex.h"
+#include "Constants.h"
+#include "Pd/Interface.h"
+
+PatchSearchIndex::PatchSearchIndex(pd::Instance* instance)
+    : pd(instance)
+{
+}
+
+std::vector<PatchSearchIndex::Entry> PatchSearchIndex::readPatch(t_glist* patch, String& title, bool& isRoot)
+{
+    std::vector<Entry> result;
+
+    // Pd's system lock is the audio lock, so this blocks the audio thread while it runs
+    // That's why we only ever read a single patch level at a time, and only once per synchronise
+    sys_lock();
+
+    isRoot = patch->gl_owner == nullptr;
+    title = patch->gl_name ? String::fromUTF8(patch->gl_name->s_name) : String();
+
+    for (t_gobj* y = patch->gl_list; y; y = y->g_next) {
+        auto* object = pd::Interface::checkObject(y);
+        if (!object)
+            continue;
+
+        Entry entry;
+        entry.object = y;
+        entry.patch = patch;
+        entry.className = String::fromUTF8(pd::Interface::getObjectClassName(&y->g_pd));
+
+        char* objectText;
+        int len;
+        pd::Interface::getObjectText(object, &objectText, &len);
+        entry.text = String::fromUTF8(objectText, len);
+        freebytes(objectText, len);
+        entry.sendReceiveName = getSendReceiveName(y, entry.className, entry.text);
+
+        int x, y1, w, h;
+        pd::Interface::getObjectBounds(patch, y, &x, &y1, &w, &h);
+        entry.position = { x, y1 };
+
+        if (pd_class(&y->g_pd) == canvas_class) {
+            entry.subpatch = y;
+            entry.isAbstraction = canvas_isabstraction(reinterpret_cast<t_canvas*>(y));
+        }
+
+        result.push_back(entry);
+    }
+
+    sys_unlock();
+
+    return result;
+}
+
+String PatchSearchIndex::getSendReceiveName(t_gobj* object, String const& className, String const& text)
+{
+    switch (hash(className)) {
+    case hash("send"):
+    case hash("receive"):
+    case hash("send~"):
+    case hash("receive~"):
+    case hash("throw~"):
+    case hash("catch~"):
+        // Without an argument, the name is set through an inlet
+        return StringArray::fromTokens(text, true)[1];
+    case hash("bng"):
+    case hash("tgl"):
+    case hash("nbx"):
+    case hash("vsl"):
+    case hash("hsl"):
+    case hash("vradio"):
+    case hash("hradio"):
+    case hash("vu"):
+    case hash("cnv"): {
+        auto* iemgui = reinterpret_cast<t_iemgui*>(object);
+        StringArray names;
+        for (auto* name : { iemgui->x_snd_unexpanded, iemgui->x_rcv_unexpanded }) {
+            if (name && name != gensym("empty") && *name->s_name)
+                names.addIfNotAlreadyThere(String::fromUTF8(name->s_name));
+        }
+        return names.joinIntoString(" ");
+    }
+    default:
+        return {};
+    }
+}
+
+void PatchSearchIndex::updatePatch(t_glist* patch)
+{
+    if (!patch)
+        return;
+
+    String title;
+    bool isRoot;
+    auto newEntries = readPatch(patch, title, isRoot);
+
+    std::vector<t_glist*> newSubpatches;
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex);
+
+        pruneDeletedPatches();
+
+        auto it = patches.find(patch);
+        if (it == patches.end()) {
+            it = patches.emplace(patch, PatchRecord { pd::WeakReference(patch, pd), {}, title, isRoot }).first;
+        }
+
+        auto& record = it->second;
+        record.title = title;
+        record.isRoot = isRoot;
+
+        std::unordered_map<void*, int> previousEntries;
+        for (auto id : record.entries) {
+            previousEntries[entries[id].object] = id;
+        }
+
+        // Only objects that were added or changed touch the trigram index
+        std::vector<int> updatedEntries;
+        for (auto& entry : newEntries) {
+            auto previous = previousEntries.find(entry.object);
+            if (previous == previousEntries.end()) {
+                updatedEntries.push_back(addEntry(entry));
+            } else {
+                auto id = previous->second;
+                previousEntries.erase(previous);
+
+                auto& oldEntry = entries[id];
+                if (oldEntry.subpatch && oldEntry.subpatch != entry.subpatch) {
+                    removePatch(oldEntry.subpatch);
+                }
+
+                if (oldEntry.text != entry.text || oldEntry.sendReceiveName != entry.sendReceiveName || oldEntry.subpatch != entry.subpatch) {
+                    removeEntry(id);
+                    id = addEntry(entry);
+                } else {
+                    oldEntry.position = entry.position;
+                    oldEntry.isAbstraction = entry.isAbstraction;
+                }
+
+                updatedEntries.push_back(id);
+            }
+
+            if (entry.subpatch && !patches.contains(entry.subpatch)) {
+                newSubpatches.push_back(static_cast<t_glist*>(entry.subpatch));
+            }
+        }
+
+        // Whatever is left was deleted
+        for (auto& [object, id] : previousEntries) {
+            if (entries[id].subpatch)
+                removePatch(entries[id].subpatch);
+            removeEntry(id);
+        }
+
+        record.entries = std::move(updatedEntries);
+        generation++;
+    }
+
+    for (auto* subpatch : newSubpatches) {
+        updatePatch(subpatch);
+    }
+}
+
+int PatchSearchIndex::addEntry(Entry const& entry)
+{
+    int id;
+    if (!freeEntries.empty()) {
+        id = freeEntries.back();
+        freeEntries.pop_back();
+        entries[id] = entry;
+    } else {
+        id = static_cast<int>(entries.size());
+        entries.push_back(entry);
+    }
+
+    objectEntries[entry.object] = id;
+    trigramIndex.add(id, StringArray(getSearchText(entry), entry.sendReceiveName));
+
+    return id;
+}
+
+void PatchSearchIndex::removeEntry(int id)
+{
+    auto& entry = entries[id];
+    trigramIndex.remove(id, StringArray(getSearchText(entry), entry.sendReceiveName));
+
+    if (auto object = objectEntries.find(entry.object); object != objectEntries.end() && object->second == id)
+        objectEntries.erase(object);
+
+    entry = Entry();
+    freeEntries.push_back(id);
+}
+
+void PatchSearchIndex::removePatch(void* patch)
+{
+    auto it = patches.find(patch);
+    if (it == patches.end())
+        return;
+
+    auto ids = std::move(it->second.entries);
+    patches.erase(it);
+
+    for (auto id : ids) {
+        if (entries[id].subpatch)
+            removePatch(entries[id].subpatch);
+        removeEntry(id);
+    }
+}
+
+void PatchSearchIndex::pruneDeletedPatches()
+{
+    std::vector<void*> deletedPatches;
+    for (auto& [patch, record] : patches) {
+        if (!record.reference.isValid())
+            deletedPatches.push_back(patch);
+    }
+
+    for (auto* patch : deletedPatches) {
+        removePatch(patch);
+    }
+}
+
+String PatchSearchIndex::getSearchText(Entry const& entry)
+{
+    return entry.text.isEmpty() ? entry.className : entry.text;
+}
+
+bool PatchSearchIndex::matches(int id, String const& filter, std::optional<std::vector<int>> const& candidates) const
+{
+    if (filter.isEmpty())
+        return true;
+
+    if (candidates && !TrigramIndex::isCandidate(*candidates, id))
+        return false;
+
+    // Trigrams can have false positives, so check the actual text
+    auto const& entry = entries[id];
+    return getSearchText(entry).containsIgnoreCase(filter) || entry.sendReceiveName.containsIgnoreCase(filter);
+}
+
+bool PatchSearchIndex::appendPatchTree(ValueTree& tree, void* patch, void* topLevel, String const& filter, std::optional<std::vector<int>> const& candidates) const
+{
+    auto it = patches.find(patch);
+    if (it == patches.end())
+        return false;
+
+    bool foundAny = false;
+    for (auto id : it->second.entries) {
+        auto const& entry = entries[id];
+        auto* top = topLevel ? topLevel : entry.object;
+
+        ValueTree element("Object");
+        bool childMatches = entry.subpatch && appendPatchTree(element, entry.subpatch, top, filter, candidates);
+
+        if (!childMatches && !matches(id, filter, candidates))
+            continue;
+
+        element.setProperty("Name", getSearchText(entry), nullptr);
+        element.setProperty("RightText", " (" + String(entry.position.x) + ":" + String(entry.position.y) + ")", nullptr);
+        element.setProperty("Icon", entry.isAbstraction ? Icons::File : Icons::Object, nullptr);
+        element.setProperty("Object", reinterpret_cast<int64>(entry.object), nullptr);
+        element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
+        if (childMatches && filter.isNotEmpty())
+            element.setProperty("OpenedBySearch", true, nullptr);
+
+        tree.appendChild(element, nullptr);
+        foundAny = true;
+    }
+
+    return foundAny;
+}
+
+ValueTree PatchSearchIndex::buildPatchTree(void* patch, String const& filter) const
+{
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+
+    ValueTree patchTree("Patch");
+    appendPatchTree(patchTree, patch, nullptr, filter, trigramIndex.findCandidates(filter));
+    return patchTree;
+}
+
+ValueTree PatchSearchIndex::buildSearchTree(String const& filter) const
+{
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+
+    auto candidates = trigramIndex.findCandidates(filter);
+
+    std::vector<std::pair<String, void*>> rootPatches;
+    for (auto const& [patch, record] : patches) {
+        if (record.isRoot && record.reference.isValid())
+            rootPatches.emplace_back(record.title, patch);
+    }
+    std::sort(rootPatches.begin(), rootPatches.end());
+
+    ValueTree searchTree("Patch");
+    for (auto const& [title, patch] : rootPatches) {
+        ValueTree element("Object");
+        if (!appendPatchTree(element, patch, nullptr, filter, candidates))
+            continue;
+
+        element.setProperty("Name", title, nullptr);
+        element.setProperty("Icon", Icons::File, nullptr);
+        element.setProperty("Object", reinterpret_cast<int64>(patch), nullptr);
+        element.setProperty("TopLevel", reinterpret_cast<int64>(patch), nullptr);
+        element.setProperty("OpenedBySearch", true, nullptr);
+        searchTree.appendChild(element, nullptr);
+    }
+
+    return searchTree;
+}
@@ -0,0 +1,82 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "Utility/Config.h"
+#include "Utility/TrigramIndex.h"
+#include "Pd/Instance.h"
+#include "Pd/WeakReference.h"
+
+// Index of all objects in all open patches, including their subpatches and abstractions
+// The index is updated one patch level at a time after that patch was synchronised, so we never have to walk the whole
+// patch tree again. Object text is indexed by trigram, so searches only have to look at a few candidates.
+// Searching and building trees only reads the index, so it can be done from any thread without taking the Pd lock.
+class PatchSearchIndex {
+public:
+    struct Entry {
+        void* object = nullptr;
+        void* patch = nullptr;    // The glist that contains this object
+        void* subpatch = nullptr; // If this object is a subpatch, graph or abstraction, its own glist
+        String text;
+        String className;
+        String sendReceiveName; // Send and receive names of [s], [r], [throw~], [catch~] and iemguis, also searched
+        Point<int> position;
+        bool isAbstraction = false;
+    };
+
+    explicit PatchSearchIndex(pd::Instance* instance);
+
+    // Message thread only: reads a single patch level from Pd and updates the index with the objects that changed
+    // Subpatches that aren't indexed yet are indexed recursively
+    void updatePatch(t_glist* patch);
+
+    // Returns a tree of the given patch for the search panel, filtered to objects that contain the filter text
+    // Elements that only contain matches further down are marked with "OpenedBySearch", so the viewer can expand them
+    ValueTree buildPatchTree(void* patch, String const& filter = String()) const;
+
+    // Returns the filtered tree of all open root patches
+    ValueTree buildSearchTree(String const& filter) const;
+
+    // Increments every time the index changes
+    int getGeneration() const { return generation.load(std::memory_order_relaxed); }
+
+private:
+    struct PatchRecord {
+        pd::WeakReference reference;
+        std::vector<int> entries;
+        String title;
+        bool isRoot = false;
+    };
+
+    std::vector<Entry> readPatch(t_glist* patch, String& title, bool& isRoot);
+
+    int addEntry(Entry const& entry);
+    void removeEntry(int id);
+    void removePatch(void* patch);
+    void pruneDeletedPatches();
+
+    static String getSearchText(Entry const& entry);
+    static String getSendReceiveName(t_gobj* object, String const& className, String const& text);
+
+    bool matches(int id, String const& filter, std::optional<std::vector<int>> const& candidates) const;
+    bool appendPatchTree(ValueTree& tree, void* patch, void* topLevel, String const& filter, std::optional<std::vector<int>> const& candidates) const;
+
+    pd::Instance* pd;
+
+    mutable std::shared_mutex indexMutex;
+    std::unordered_map<void*, PatchRecord> patches;
+    std::vector<Entry> entries;
+    std::vector<int> freeEntries;
+    std::unordered_map<void*, int> objectEntries;
+    TrigramIndex trigramIndex;
+
+    std::atomic<int> generation = 0;
+};
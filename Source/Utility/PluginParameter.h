@@ -261,15 +261,65 @@ public:
                 mode = static_cast<Mode>(xmlParam->getIntAttribute("mode"));
             }
 
-            param->setRange(min, max);
-            param->setName(name);
-            param->setIndex(index);
-            param->setMode(mode, false);
-            param->setValue(navalue);
-            param->setEnabled(enabled);
+            param->restoreState(name, min, max, enabled, index, mode, navalue);
         }
     }
 
+    // Compact state format: the parameters are written as an array of fixed records, without attribute names
+    static void saveStateInformation(OutputStream& stream, Array<AudioProcessorParameter*> const& parameters)
+    {
+        stream.writeCompressedInt(parameters.size());
+        stream.writeFloat(parameters[0]->getValue());
+
+        for (int i = 1; i < parameters.size(); i++) {
+            auto* param = dynamic_cast<PlugDataParameter*>(parameters[i]);
+
+            stream.writeString(param->getTitle());
+            stream.writeFloat(param->range.start);
+            stream.writeFloat(param->range.end);
+            stream.writeBool(param->enabled);
+            stream.writeFloat(param->getValue());
+            stream.writeCompressedInt(param->index);
+            stream.writeCompressedInt(static_cast<int>(param->mode));
+        }
+    }
+
+    static void loadStateInformation(InputStream& stream, Array<AudioProcessorParameter*> const& parameters)
+    {
+        auto numParameters = stream.readCompressedInt();
+        if (numParameters <= 0)
+            return;
+
+        parameters[0]->setValueNotifyingHost(stream.readFloat());
+
+        for (int i = 1; i < numParameters; i++) {
+            auto name = stream.readString();
+            auto min = stream.readFloat();
+            auto max = stream.readFloat();
+            auto enabled = stream.readBool();
+            auto value = stream.readFloat();
+            auto index = stream.readCompressedInt();
+            auto mode = static_cast<Mode>(stream.readCompressedInt());
+
+            // States saved by a build with more parameters: read past the ones we don't have
+            if (i >= parameters.size())
+                continue;
+
+            auto* param = dynamic_cast<PlugDataParameter*>(parameters[i]);
+            param->restoreState(name, min, max, enabled, index, mode, value);
+        }
+    }
+
+    void restoreState(String const& name, float min, float max, bool isEnabled, int newIndex, Mode newMode, float value)
+    {
+        setRange(min, max);
+        setName(name);
+        setIndex(newIndex);
+        setMode(newMode, false);
+        setValue(value);
+        setEnabled(isEnabled);
+    }
+
     void setLastValue(float v)
     {
         lastValue = v;
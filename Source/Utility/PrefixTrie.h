@@ -0,0 +1,177 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include "Utility/Config.h"
+
+// Prefix tree of object names, used for autocompletion
+// Every node caches the best ranked names below it, so a lookup only has to walk down the prefix
+// Names are ranked by how often they were used, then by length, then alphabetically
+class PrefixTrie {
+public:
+    static constexpr int maxRankedResults = 20;
+
+    void clear()
+    {
+        nodes.clear();
+        nodes.emplace_back();
+        words.clear();
+        wordIndex.clear();
+    }
+
+    void insert(String const& name)
+    {
+        if (name.isEmpty() || wordIndex.contains(name))
+            return;
+
+        int node = 0;
+        for (auto character : name) {
+            node = getOrCreateChild(node, character);
+            nodes[node].bestIsValid = false;
+        }
+        nodes[0].bestIsValid = false;
+
+        auto usage = usageCounts.find(name);
+        auto id = static_cast<int>(words.size());
+        words.push_back({ name, usage != usageCounts.end() ? usage->second : 0 });
+        wordIndex[name] = id;
+        nodes[node].word = id;
+    }
+
+    // Usage counts are kept when the trie is cleared, so they survive a library update
+    void incrementUsage(String const& name)
+    {
+        setUsage(name, getUsage(name) + 1);
+    }
+
+    void setUsage(String const& name, int usage)
+    {
+        usageCounts[name] = usage;
+
+        auto word = wordIndex.find(name);
+        if (word == wordIndex.end())
+            return;
+
+        words[word->second].usage = usage;
+
+        // Only the nodes on the path to this name need to be re-ranked
+        int node = 0;
+        nodes[0].bestIsValid = false;
+        for (auto character : name) {
+            node = findChild(node, character);
+            if (node < 0)
+                break;
+            nodes[node].bestIsValid = false;
+        }
+    }
+
+    int getUsage(String const& name) const
+    {
+        auto usage = usageCounts.find(name);
+        return usage != usageCounts.end() ? usage->second : 0;
+    }
+
+    std::unordered_map<String, int> const& getUsageCounts() const
+    {
+        return usageCounts;
+    }
+
+    StringArray findWithPrefix(String const& prefix, int maxResults = maxRankedResults)
+    {
+        StringArray result;
+
+        int node = 0;
+        for (auto character : prefix) {
+            node = findChild(node, character);
+            if (node < 0)
+                return result;
+        }
+
+        for (auto id : getBest(node)) {
+            if (result.size() >= maxResults)
+                break;
+            result.add(words[id].name);
+        }
+
+        return result;
+    }
+
+private:
+    struct Node {
+        std::vector<std::pair<juce_wchar, int>> children; // Sorted by character
+        std::vector<int> best;
+        int word = -1;
+        bool bestIsValid = false;
+    };
+
+    struct Word {
+        String name;
+        int usage;
+    };
+
+    int findChild(int node, juce_wchar character) const
+    {
+        auto const& children = nodes[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), character, [](auto const& child, juce_wchar c) { return child.first < c; });
+        return it != children.end() && it->first == character ? it->second : -1;
+    }
+
+    int getOrCreateChild(int node, juce_wchar character)
+    {
+        auto existing = findChild(node, character);
+        if (existing >= 0)
+            return existing;
+
+        auto child = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+
+        auto& children = nodes[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), character, [](auto const& c, juce_wchar ch) { return c.first < ch; });
+        children.insert(it, { character, child });
+        return child;
+    }
+
+    bool isRankedHigher(int a, int b) const
+    {
+        auto const& first = words[a];
+        auto const& second = words[b];
+        if (first.usage != second.usage)
+            return first.usage > second.usage;
+        if (first.name.length() != second.name.length())
+            return first.name.length() < second.name.length();
+        return first.name < second.name;
+    }
+
+    std::vector<int> const& getBest(int node)
+    {
+        if (nodes[node].bestIsValid)
+            return nodes[node].best;
+
+        std::vector<int> candidates;
+        if (nodes[node].word >= 0)
+            candidates.push_back(nodes[node].word);
+
+        for (auto const& [character, child] : nodes[node].children) {
+            auto const& childBest = getBest(child);
+            candidates.insert(candidates.end(), childBest.begin(), childBest.end());
+        }
+
+        auto numBest = std::min<size_t>(candidates.size(), maxRankedResults);
+        std::partial_sort(candidates.begin(), candidates.begin() + numBest, candidates.end(), [this](int a, int b) { return isRankedHigher(a, b); });
+        candidates.resize(numBest);
+
+        nodes[node].best = std::move(candidates);
+        nodes[node].bestIsValid = true;
+        return nodes[node].best;
+    }
+
+    std::vector<Node> nodes = std::vector<Node>(1);
+    std::vector<Word> words;
+    std::unordered_map<String, int> wordIndex;
+    std::unordered_map<String, int> usageCounts;
+};
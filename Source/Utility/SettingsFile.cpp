@@ -81,7 +81,8 @@ SettingsFile* SettingsFile::initialise()
     saveSettings();
 
     settingsTree.addListener(this);
-    settingsFileWatcher.addFolder(settingsFile.getParentDirectory());
+    // Only the settings file itself matters, so don't watch the rest of the app data folder
+    settingsFileWatcher.addFolder(settingsFile.getParentDirectory(), false);
     settingsFileWatcher.addListener(this);
 
     return this;
@@ -344,11 +345,14 @@ void SettingsFile::reloadSettings()
     }
 }
 
-void SettingsFile::fileChanged(File const file, FileSystemWatcher::FileSystemEvent fileEvent)
+bool SettingsFile::isInterestedIn(File const& file)
 {
-    if(file == settingsFile) {
-        reloadSettings();
-    }
+    return file == settingsFile;
+}
+
+void SettingsFile::filesystemChanged()
+{
+    reloadSettings();
 }
 
 void SettingsFile::valueTreePropertyChanged(ValueTree& treeWhosePropertyHasChanged, Identifier const& property)
@@ -49,7 +49,8 @@ public:
 
     void reloadSettings();
         
-    void fileChanged(File const file, FileSystemWatcher::FileSystemEvent fileEvent) override;
+    bool isInterestedIn(File const& file) override;
+    void filesystemChanged() override;
 
     void valueTreePropertyChanged(ValueTree& treeWhosePropertyHasChanged, Identifier const& property) override;
     void valueTreeChildAdded(ValueTree& parentTree, ValueTree& childWhichHasBeenAdded) override;
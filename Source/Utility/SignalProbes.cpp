@@ -0,0 +1,202 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "SignalProbes.h"
+
+SignalProbe::SignalProbe(pd::Instance* instance, t_outconnect* oc, int channelIndex, String probeName)
+    : connection(oc, instance)
+    , channel(channelIndex)
+    , name(std::move(probeName))
+{
+}
+
+void SignalProbe::write(t_float const* samples, int numSamples)
+{
+    // If the reader falls behind we drop the new block instead of waiting for it
+    if (fifo.getFreeSpace() < numSamples) {
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto scope = fifo.write(numSamples);
+    if (scope.blockSize1 > 0)
+        std::copy(samples, samples + scope.blockSize1, ring.data() + scope.startIndex1);
+    if (scope.blockSize2 > 0)
+        std::copy(samples + scope.blockSize1, samples + numSamples, ring.data() + scope.startIndex2);
+}
+
+void SignalProbe::analyse()
+{
+    auto numReady = fifo.getNumReady();
+    if (numReady == 0) {
+        rms = 0.0f;
+        peak *= 0.9f;
+        return;
+    }
+
+    float sumOfSquares = 0.0f;
+    float blockPeak = 0.0f;
+    auto consume = [this, &sumOfSquares, &blockPeak](int start, int size) {
+        for (int i = start; i < start + size; i++) {
+            auto sample = ring[i];
+            sumOfSquares += sample * sample;
+            blockPeak = std::max(blockPeak, std::abs(sample));
+            history[historyPosition] = sample;
+            historyPosition = (historyPosition + 1) % fftSize;
+        }
+    };
+
+    {
+        auto scope = fifo.read(numReady);
+        consume(scope.startIndex1, scope.blockSize1);
+        consume(scope.startIndex2, scope.blockSize2);
+    }
+
+    rms = std::sqrt(sumOfSquares / static_cast<float>(numReady));
+    peak = std::max(blockPeak, peak * 0.9f);
+
+    // Unroll the circular history so the oldest sample comes first
+    auto* fftData = fftBuffer.data();
+    std::copy(history.begin() + historyPosition, history.end(), fftData);
+    std::copy(history.begin(), history.begin() + historyPosition, fftData + (fftSize - historyPosition));
+    std::fill(fftData + fftSize, fftData + fftSize * 2, 0.0f);
+
+    window.multiplyWithWindowingTable(fftData, fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData, true);
+
+    // A full-scale sine ends up at fftSize / 4 after the hann window, normalise that to 0 dB
+    constexpr float normalisation = 4.0f / static_cast<float>(fftSize);
+    for (int i = 0; i < numBins; i++) {
+        spectrum[i] = Decibels::gainToDecibels(fftData[i] * normalisation, -120.0f);
+    }
+}
+
+SignalProbeManager::SignalProbeManager(pd::Instance* instance)
+    : pd(instance)
+{
+    pd->registerSignalTap(this);
+}
+
+SignalProbeManager::~SignalProbeManager()
+{
+    pd->unregisterSignalTap(this);
+}
+
+bool SignalProbeManager::addProbe(t_outconnect* oc, int channel, String const& name)
+{
+    if (hasProbe(oc, channel))
+        return true;
+
+    if (probes.size() >= maxProbedChannels)
+        return false;
+
+    auto* probe = new SignalProbe(pd, oc, channel, name);
+
+    // The audio thread only iterates the probes while holding the Pd lock
+    pd->lockAudioThread();
+    probes.add(probe);
+    pd->unlockAudioThread();
+
+    if (!isFrameTimerRunning())
+        startFrameTimerHz(30);
+
+    listeners.call([](Listener& l) { l.signalProbesChanged(); });
+    return true;
+}
+
+void SignalProbeManager::removeProbe(SignalProbe* probe)
+{
+    pd->lockAudioThread();
+    probes.removeObject(probe);
+    pd->unlockAudioThread();
+
+    if (probes.isEmpty())
+        stopFrameTimer();
+
+    listeners.call([](Listener& l) { l.signalProbesChanged(); });
+}
+
+void SignalProbeManager::removeProbesForConnection(t_outconnect* oc)
+{
+    pd->lockAudioThread();
+    for (int i = probes.size() - 1; i >= 0; i--) {
+        if (probes[i]->connection == oc)
+            probes.remove(i);
+    }
+    pd->unlockAudioThread();
+
+    if (probes.isEmpty())
+        stopFrameTimer();
+
+    listeners.call([](Listener& l) { l.signalProbesChanged(); });
+}
+
+void SignalProbeManager::clear()
+{
+    pd->lockAudioThread();
+    probes.clear();
+    pd->unlockAudioThread();
+
+    stopFrameTimer();
+    listeners.call([](Listener& l) { l.signalProbesChanged(); });
+}
+
+bool SignalProbeManager::hasProbe(t_outconnect* oc, int channel) const
+{
+    for (auto* probe : probes) {
+        if (probe->connection == oc && probe->channel == channel)
+            return true;
+    }
+
+    return false;
+}
+
+void SignalProbeManager::tapSignals()
+{
+    sampleRate.store(sys_getsr(), std::memory_order_relaxed);
+
+    for (auto* probe : probes) {
+        auto* oc = probe->connection.getRaw<t_outconnect>();
+        if (!oc) {
+            probe->droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // The connection doesn't carry a signal right now, so this block is lost for the analysis
+        auto* signal = outconnect_get_signal(oc);
+        if (!signal || !signal->s_vec || probe->channel >= signal->s_nchans) {
+            probe->droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        probe->write(signal->s_vec + (probe->channel * signal->s_n), signal->s_n);
+    }
+}
+
+void SignalProbeManager::frameTimerCallback()
+{
+    bool removedProbes = false;
+    for (int i = probes.size() - 1; i >= 0; i--) {
+        // The connection was deleted in Pd, so this probe has nothing left to tap
+        if (!probes[i]->connection.isValid()) {
+            pd->lockAudioThread();
+            probes.remove(i);
+            pd->unlockAudioThread();
+            removedProbes = true;
+            continue;
+        }
+
+        probes[i]->analyse();
+    }
+
+    if (probes.isEmpty())
+        stopFrameTimer();
+
+    if (removedProbes)
+        listeners.call([](Listener& l) { l.signalProbesChanged(); });
+
+    listeners.call([](Listener& l) { l.signalProbesUpdated(); });
+}
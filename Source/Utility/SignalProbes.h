@@ -0,0 +1,105 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "Utility/Config.h"
+#include "Utility/FrameScheduler.h"
+#include "Pd/Instance.h"
+#include "Pd/WeakReference.h"
+
+// Taps a single channel of a signal connection
+// The audio thread pushes every DSP block into a lock-free ring, the message thread drains it and runs the analysis
+class SignalProbe {
+public:
+    static constexpr int ringSize = 1 << 14;
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2;
+
+    SignalProbe(pd::Instance* instance, t_outconnect* oc, int channelIndex, String probeName);
+
+    // Audio thread only
+    void write(t_float const* samples, int numSamples);
+
+    // Message thread only: reads new samples from the ring and updates the analysis results
+    void analyse();
+
+    pd::WeakReference connection;
+    int const channel;
+    String const name;
+
+    // Analysis results, only valid on the message thread
+    float rms = 0.0f;
+    float peak = 0.0f;
+    std::array<float, fftSize> history = {};
+    std::array<float, numBins> spectrum = {};
+    int historyPosition = 0;
+
+    // Blocks that couldn't be written, because the ring was full or the connection carried no signal
+    std::atomic<int> droppedBlocks = 0;
+
+private:
+    AbstractFifo fifo { ringSize };
+    std::vector<float> ring = std::vector<float>(ringSize, 0.0f);
+
+    std::array<float, fftSize * 2> fftBuffer = {};
+    dsp::FFT fft { fftOrder };
+    dsp::WindowingFunction<float> window { static_cast<size_t>(fftSize), dsp::WindowingFunction<float>::hann };
+
+    JUCE_DECLARE_NON_COPYABLE(SignalProbe)
+};
+
+// Owns all pinned probes of a Pd instance
+// Probes are written right after every DSP tick, inside the lock the tick already ran under, so no block is skipped
+// and the audio thread never waits for the message thread. The analysis happens on the message thread once per frame
+class SignalProbeManager : public pd::SignalTap
+    , private FrameTimer {
+public:
+    struct Listener {
+        virtual ~Listener() = default;
+
+        // Probes were added or removed
+        virtual void signalProbesChanged() = 0;
+
+        // New analysis results are available
+        virtual void signalProbesUpdated() = 0;
+    };
+
+    // Upper bound on the total number of probed channels, to limit the cost of tapping in the DSP loop
+    static constexpr int maxProbedChannels = 32;
+
+    explicit SignalProbeManager(pd::Instance* instance);
+    ~SignalProbeManager() override;
+
+    // Returns false if the probe couldn't be added because the bandwidth cap was reached
+    bool addProbe(t_outconnect* oc, int channel, String const& name);
+    void removeProbe(SignalProbe* probe);
+    void removeProbesForConnection(t_outconnect* oc);
+    void clear();
+
+    bool hasProbe(t_outconnect* oc, int channel) const;
+    int getNumProbes() const { return probes.size(); }
+    int getRemainingCapacity() const { return maxProbedChannels - probes.size(); }
+    SignalProbe* getProbe(int index) const { return probes[index]; }
+
+    float getSampleRate() const { return sampleRate.load(std::memory_order_relaxed); }
+
+    void addListener(Listener* listener) { listeners.add(listener); }
+    void removeListener(Listener* listener) { listeners.remove(listener); }
+
+private:
+    void tapSignals() override;
+    void frameTimerCallback() override;
+
+    pd::Instance* pd;
+    OwnedArray<SignalProbe> probes;
+    ListenerList<Listener> listeners;
+    std::atomic<float> sampleRate = 44100.0f;
+
+    JUCE_DECLARE_NON_COPYABLE(SignalProbeManager)
+};
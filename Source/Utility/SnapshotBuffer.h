@@ -0,0 +1,48 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include <atomic>
+
+// Lock-free triple buffer to pass snapshots of data from the audio thread to the message thread
+// The writer always has a free buffer to write into, and the reader always gets the latest complete snapshot,
+// so neither side ever has to wait for the other
+template<typename T>
+class SnapshotBuffer {
+public:
+    // Returns the buffer to write the next snapshot into (writer only)
+    T& beginWrite()
+    {
+        return buffers[backIndex];
+    }
+
+    // Publishes the snapshot that was written since the last beginWrite() (writer only)
+    void endWrite()
+    {
+        auto previous = middleIndex.exchange(backIndex | newDataFlag, std::memory_order_acq_rel);
+        backIndex = previous & indexMask;
+    }
+
+    // Returns the latest published snapshot, or nullptr if nothing was published since the last read (reader only)
+    T const* read()
+    {
+        if (!(middleIndex.load(std::memory_order_relaxed) & newDataFlag))
+            return nullptr;
+
+        auto previous = middleIndex.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & indexMask;
+        return &buffers[frontIndex];
+    }
+
+private:
+    static constexpr int newDataFlag = 4;
+    static constexpr int indexMask = 3;
+
+    T buffers[3];
+    int backIndex = 0;
+    std::atomic<int> middleIndex = 1;
+    int frontIndex = 2;
+};
@@ -0,0 +1,139 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <ctime>
+
+#include "Utility/Config.h"
+#include "StartupTrace.h"
+
+namespace {
+thread_local int currentDepth = 0;
+}
+
+StartupTrace::ScopedPhase::ScopedPhase(String phaseName, int instanceId)
+    : name(std::move(phaseName))
+    , instance(instanceId)
+    , depth(currentDepth++)
+{
+    // Make sure the trace exists before we start timing, so its origin is never after the start of a phase
+    StartupTrace::getInstance();
+
+    startTime = Time::getMillisecondCounterHiRes();
+    startCpuTime = getThreadCpuTime();
+}
+
+StartupTrace::ScopedPhase::~ScopedPhase()
+{
+    currentDepth--;
+
+    auto* trace = StartupTrace::getInstance();
+    trace->addPhase({ name,
+        instance,
+        depth,
+        static_cast<int64>(reinterpret_cast<pointer_sized_int>(Thread::getCurrentThreadId())),
+        startTime - trace->origin,
+        Time::getMillisecondCounterHiRes() - startTime,
+        getThreadCpuTime() - startCpuTime });
+}
+
+StartupTrace::~StartupTrace()
+{
+    clearSingletonInstance();
+}
+
+double StartupTrace::getThreadCpuTime()
+{
+#if JUCE_WINDOWS
+    // Process CPU time, Windows has no portable per-thread equivalent in the C runtime
+    return static_cast<double>(std::clock()) * 1000.0 / CLOCKS_PER_SEC;
+#else
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+        return 0.0;
+
+    return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_nsec) / 1000000.0;
+#endif
+}
+
+void StartupTrace::addPhase(Phase const& phase)
+{
+    {
+        std::lock_guard<std::mutex> lock(phasesLock);
+
+        // Phases that run again later (like updating the library) shouldn't make this grow forever
+        if (phases.size() >= maxPhases)
+            return;
+
+        phases.push_back(phase);
+    }
+
+    // Keep the trace file up to date whenever a top level phase finishes
+    if (phase.depth == 0) {
+        auto tracePath = SystemStats::getEnvironmentVariable("PLUGDATA_STARTUP_TRACE", {});
+        if (tracePath.isNotEmpty() && File::isAbsolutePath(tracePath))
+            writeChromeTrace(File(tracePath));
+    }
+}
+
+std::vector<StartupTrace::Phase> StartupTrace::getPhases() const
+{
+    std::lock_guard<std::mutex> lock(phasesLock);
+    auto result = phases;
+
+    // Phases are added when they end, sort them by when they started so nested phases follow their parent
+    std::stable_sort(result.begin(), result.end(), [](Phase const& a, Phase const& b) {
+        return a.startTime < b.startTime;
+    });
+
+    return result;
+}
+
+String StartupTrace::getSummary() const
+{
+    String summary;
+    for (auto const& phase : getPhases()) {
+        summary += String::repeatedString("    ", phase.depth) + phase.name;
+        if (phase.instance > 0)
+            summary += " (instance " + String(phase.instance) + ")";
+        summary += ": " + String(phase.wallTime, 1) + " ms wall, " + String(phase.cpuTime, 1) + " ms cpu\n";
+    }
+
+    return summary.trimEnd();
+}
+
+var StartupTrace::toChromeTrace() const
+{
+    Array<var> events;
+    for (auto const& phase : getPhases()) {
+        auto* args = new DynamicObject();
+        args->setProperty("cpu_ms", phase.cpuTime);
+        args->setProperty("instance", phase.instance);
+
+        // Complete events, timestamps are in microseconds
+        auto* event = new DynamicObject();
+        event->setProperty("name", phase.name);
+        event->setProperty("cat", "startup");
+        event->setProperty("ph", "X");
+        event->setProperty("ts", phase.startTime * 1000.0);
+        event->setProperty("dur", phase.wallTime * 1000.0);
+        event->setProperty("pid", 1);
+        event->setProperty("tid", phase.threadId);
+        event->setProperty("args", var(args));
+        events.add(var(event));
+    }
+
+    auto* trace = new DynamicObject();
+    trace->setProperty("traceEvents", events);
+    trace->setProperty("displayTimeUnit", "ms");
+    return var(trace);
+}
+
+bool StartupTrace::writeChromeTrace(File const& file) const
+{
+    return file.replaceWithText(JSON::toString(toChromeTrace()));
+}
+
+JUCE_IMPLEMENT_SINGLETON(StartupTrace)
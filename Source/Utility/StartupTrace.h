@@ -0,0 +1,65 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <mutex>
+#include "Utility/Config.h"
+
+// Records how long the phases of plugin instantiation take, in wall time and CPU time of the calling thread
+// The summary is shown in the about panel. If the PLUGDATA_STARTUP_TRACE environment variable is set to a file path,
+// the timeline is also written there in Chrome's trace event format (open it in chrome://tracing or Perfetto)
+class StartupTrace : public DeletedAtShutdown {
+public:
+    struct Phase {
+        String name;
+        int instance;
+        int depth;
+        int64 threadId;
+        double startTime; // Milliseconds since the first phase of this process started
+        double wallTime;  // Milliseconds
+        double cpuTime;   // Milliseconds
+    };
+
+    // Times the enclosing scope as a phase
+    class ScopedPhase {
+    public:
+        ScopedPhase(String phaseName, int instanceId = 0);
+        ~ScopedPhase();
+
+    private:
+        String name;
+        int instance;
+        int depth;
+        double startTime = 0.0;
+        double startCpuTime = 0.0;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedPhase)
+    };
+
+    ~StartupTrace() override;
+
+    std::vector<Phase> getPhases() const;
+
+    // Human readable summary of all phases, indented by nesting depth
+    String getSummary() const;
+
+    var toChromeTrace() const;
+    bool writeChromeTrace(File const& file) const;
+
+    JUCE_DECLARE_SINGLETON(StartupTrace, false)
+
+private:
+    void addPhase(Phase const& phase);
+
+    static double getThreadCpuTime();
+
+    mutable std::mutex phasesLock;
+    std::vector<Phase> phases;
+    double const origin = Time::getMillisecondCounterHiRes();
+
+    static constexpr size_t maxPhases = 4096;
+};
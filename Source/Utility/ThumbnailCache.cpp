@@ -0,0 +1,206 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "ThumbnailCache.h"
+
+ThumbnailCache::ThumbnailCache()
+    : ThumbnailCache(ProjectInfo::appDataDir.getChildFile(".thumbnails"), 32 * 1024 * 1024, 64 * 1024 * 1024, 4)
+{
+}
+
+ThumbnailCache::ThumbnailCache(File directory, size_t memoryBytes, int64 diskBytes, int numDownloadThreads)
+    : cacheDirectory(std::move(directory))
+    , maxMemoryBytes(memoryBytes)
+    , maxDiskBytes(diskBytes)
+    , downloadPool(numDownloadThreads)
+{
+    cacheDirectory.createDirectory();
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    downloadPool.removeAllJobs(true, -1);
+}
+
+String ThumbnailCache::getKey(URL const& url, int width, int height)
+{
+    return String::toHexString(url.toString(true).hashCode64()) + "_" + String(width) + "x" + String(height);
+}
+
+File ThumbnailCache::getCacheFile(String const& key) const
+{
+    return cacheDirectory.getChildFile(key + ".png");
+}
+
+Image ThumbnailCache::getCachedThumbnail(URL const& url, int width, int height)
+{
+    ScopedLock lock(cacheLock);
+
+    auto entry = memoryCache.find(getKey(url, width, height));
+    if (entry == memoryCache.end())
+        return {};
+
+    recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, entry->second.position);
+    return entry->second.image;
+}
+
+void ThumbnailCache::requestThumbnail(URL const& url, int width, int height, Callback callback)
+{
+    if (width <= 0 || height <= 0 || !url.isWellFormed()) {
+        callback({});
+        return;
+    }
+
+    if (auto image = getCachedThumbnail(url, width, height); image.isValid()) {
+        callback(image);
+        return;
+    }
+
+    auto key = getKey(url, width, height);
+    {
+        ScopedLock lock(cacheLock);
+
+        // Already on its way, just wait for it too
+        auto& callbacks = pendingRequests[key];
+        callbacks.push_back(std::move(callback));
+        if (callbacks.size() > 1)
+            return;
+    }
+
+    downloadPool.addJob([this, url, width, height, key]() {
+        auto image = fetchThumbnail(url, width, height, key);
+
+        std::vector<Callback> callbacks;
+        {
+            ScopedLock lock(cacheLock);
+            if (image.isValid())
+                addToMemoryCache(key, image);
+
+            callbacks = std::move(pendingRequests[key]);
+            pendingRequests.erase(key);
+        }
+
+        MessageManager::callAsync([callbacks = std::move(callbacks), image]() {
+            for (auto const& callback : callbacks) {
+                callback(image);
+            }
+        });
+    });
+}
+
+Image ThumbnailCache::fetchThumbnail(URL const& url, int width, int height, String const& key)
+{
+    auto cacheFile = getCacheFile(key);
+
+    // Thumbnails on disk already have the right size, so all we have to do is decode them
+    if (cacheFile.existsAsFile()) {
+        auto image = ImageFileFormat::loadFrom(cacheFile);
+        if (image.isValid()) {
+            cacheFile.setLastModificationTime(Time::getCurrentTime());
+            return SoftwareImageType().convert(image);
+        }
+
+        cacheFile.deleteFile();
+    }
+
+    int statusCode = 0;
+    auto stream = url.createInputStream(URL::InputStreamOptions(URL::ParameterHandling::inAddress)
+                                            .withConnectionTimeoutMs(downloadTimeout)
+                                            .withStatusCode(&statusCode));
+
+    if (stream == nullptr || statusCode != 200)
+        return {};
+
+    MemoryBlock block;
+    stream->readIntoMemoryBlock(block);
+
+    auto image = ImageFileFormat::loadFrom(block.getData(), block.getSize());
+    if (!image.isValid())
+        return {};
+
+    auto thumbnail = createThumbnail(SoftwareImageType().convert(image), width, height);
+
+    // Write to a temporary file first, so a reader never sees a half written thumbnail
+    TemporaryFile temporary(cacheFile);
+    {
+        FileOutputStream output(temporary.getFile());
+        PNGImageFormat png;
+        if (!output.openedOk() || !png.writeImageToStream(thumbnail, output))
+            return thumbnail;
+    }
+
+    if (temporary.overwriteTargetFileWithTemporary())
+        trimDiskCache();
+
+    return thumbnail;
+}
+
+Image ThumbnailCache::createThumbnail(Image const& image, int width, int height)
+{
+    auto scale = jmax(static_cast<float>(width) / image.getWidth(), static_cast<float>(height) / image.getHeight());
+
+    // Keep the image centered
+    auto translateX = (width - image.getWidth() * scale) * 0.5f;
+    auto translateY = (height - image.getHeight() * scale) * 0.5f;
+
+    Image thumbnail(Image::ARGB, width, height, true, SoftwareImageType());
+    Graphics g(thumbnail);
+    g.setImageResamplingQuality(Graphics::highResamplingQuality);
+    g.drawImageTransformed(image, AffineTransform::scale(scale).translated(translateX, translateY));
+
+    return thumbnail;
+}
+
+void ThumbnailCache::addToMemoryCache(String const& key, Image const& image)
+{
+    if (memoryCache.count(key))
+        return;
+
+    recentlyUsed.push_front(key);
+    memoryCache[key] = { image, recentlyUsed.begin() };
+    memoryCacheBytes += static_cast<size_t>(image.getWidth()) * static_cast<size_t>(image.getHeight()) * 4;
+
+    // Drop the least recently used thumbnails, but always keep the one we just added
+    while (memoryCacheBytes > maxMemoryBytes && recentlyUsed.size() > 1) {
+        auto entry = memoryCache.find(recentlyUsed.back());
+        auto const& evicted = entry->second.image;
+        memoryCacheBytes -= static_cast<size_t>(evicted.getWidth()) * static_cast<size_t>(evicted.getHeight()) * 4;
+        memoryCache.erase(entry);
+        recentlyUsed.pop_back();
+    }
+}
+
+void ThumbnailCache::trimDiskCache()
+{
+    struct CachedFile {
+        File file;
+        int64 size;
+        Time lastUsed;
+    };
+
+    std::vector<CachedFile> files;
+    int64 totalSize = 0;
+    for (auto const& file : cacheDirectory.findChildFiles(File::findFiles, false, "*.png")) {
+        files.push_back({ file, file.getSize(), file.getLastModificationTime() });
+        totalSize += files.back().size;
+    }
+
+    if (totalSize <= maxDiskBytes)
+        return;
+
+    // Reading a thumbnail touches its modification time, so the oldest ones are the least recently used
+    std::sort(files.begin(), files.end(), [](CachedFile const& a, CachedFile const& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+
+    for (auto const& [file, size, lastUsed] : files) {
+        if (totalSize <= maxDiskBytes)
+            break;
+
+        totalSize -= size;
+        file.deleteFile();
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+
+// Downloads images and keeps them as thumbnails of the size they're shown at, in memory and on disk
+// Thumbnails are keyed by URL and size. Both caches drop the least recently used thumbnails when they're over budget.
+// Downloading, decoding and scaling happens on a small pool of threads, so only a few downloads run at once, and a
+// thumbnail that is requested again while it's being fetched is only fetched once
+// Held through a SharedResourcePointer, so all browsers share one cache
+class ThumbnailCache {
+public:
+    using Callback = std::function<void(Image)>;
+
+    ThumbnailCache();
+    ThumbnailCache(File cacheDirectory, size_t maxMemoryBytes, int64 maxDiskBytes, int numDownloadThreads);
+    ~ThumbnailCache();
+
+    // Returns the thumbnail if it's in memory, otherwise an invalid image
+    Image getCachedThumbnail(URL const& url, int width, int height);
+
+    // Calls back on the message thread with the thumbnail, or an invalid image if it couldn't be downloaded
+    // The image is scaled to cover the size, and cropped to it
+    void requestThumbnail(URL const& url, int width, int height, Callback callback);
+
+    // Scales the image so it covers the size and crops the centre
+    static Image createThumbnail(Image const& image, int width, int height);
+
+private:
+    static String getKey(URL const& url, int width, int height);
+    File getCacheFile(String const& key) const;
+
+    Image fetchThumbnail(URL const& url, int width, int height, String const& key);
+    void addToMemoryCache(String const& key, Image const& image);
+    void trimDiskCache();
+
+    File const cacheDirectory;
+    size_t const maxMemoryBytes;
+    int64 const maxDiskBytes;
+
+    struct MemoryEntry {
+        Image image;
+        std::list<String>::iterator position;
+    };
+
+    CriticalSection cacheLock;
+    std::list<String> recentlyUsed; // Most recently used first
+    std::unordered_map<String, MemoryEntry> memoryCache;
+    size_t memoryCacheBytes = 0;
+    std::unordered_map<String, std::vector<Callback>> pendingRequests;
+
+    ThreadPool downloadPool;
+
+    static constexpr int downloadTimeout = 10000;
+};
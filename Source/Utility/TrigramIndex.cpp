@@ -0,0 +1,89 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <iterator>
+
+#include "TrigramIndex.h"
+
+void TrigramIndex::add(int id, StringArray const& texts)
+{
+    for (auto trigram : getTrigrams(texts)) {
+        auto& ids = postings[trigram];
+
+        // Ids are usually added in order, then this is just an append
+        if (ids.empty() || ids.back() < id)
+            ids.push_back(id);
+        else if (auto position = std::lower_bound(ids.begin(), ids.end(), id); position == ids.end() || *position != id)
+            ids.insert(position, id);
+    }
+}
+
+void TrigramIndex::remove(int id, StringArray const& texts)
+{
+    for (auto trigram : getTrigrams(texts)) {
+        auto posting = postings.find(trigram);
+        if (posting == postings.end())
+            continue;
+
+        auto& ids = posting->second;
+        if (auto position = std::lower_bound(ids.begin(), ids.end(), id); position != ids.end() && *position == id)
+            ids.erase(position);
+        if (ids.empty())
+            postings.erase(posting);
+    }
+}
+
+std::optional<std::vector<int>> TrigramIndex::findCandidates(String const& query) const
+{
+    auto trigrams = getTrigrams(StringArray(query));
+    if (trigrams.empty())
+        return std::nullopt;
+
+    // Start with the smallest posting list, and intersect it with the others
+    std::vector<std::vector<int> const*> lists;
+    for (auto trigram : trigrams) {
+        auto posting = postings.find(trigram);
+        if (posting == postings.end())
+            return std::vector<int>();
+        lists.push_back(&posting->second);
+    }
+
+    std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+
+    auto candidates = *lists.front();
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        std::vector<int> intersection;
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    return candidates;
+}
+
+std::vector<TrigramIndex::Trigram> TrigramIndex::getTrigrams(StringArray const& texts)
+{
+    std::vector<Trigram> trigrams;
+    for (auto const& text : texts) {
+        auto lowercase = text.toLowerCase();
+        auto characters = lowercase.getCharPointer();
+
+        juce_wchar previous[2] = { 0, 0 };
+        int count = 0;
+        while (!characters.isEmpty()) {
+            auto character = characters.getAndAdvance();
+            if (count >= 2) {
+                trigrams.push_back((static_cast<Trigram>(previous[0]) * 31u + static_cast<Trigram>(previous[1])) * 31u + static_cast<Trigram>(character));
+            }
+            previous[0] = previous[1];
+            previous[1] = character;
+            count++;
+        }
+    }
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
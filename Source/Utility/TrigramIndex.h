@@ -0,0 +1,43 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "Utility/Config.h"
+
+// Maps every trigram of the indexed text to the ids of the items that contain it, so a substring search only has to
+// look at the items that contain all trigrams of the query. Trigrams are case-insensitive and can have false
+// positives, so the caller still checks the text of the candidates.
+class TrigramIndex {
+public:
+    // Indexes the text of an item, ids don't have to be added in order
+    void add(int id, StringArray const& texts);
+
+    // Removes an item, with the same text it was added with
+    void remove(int id, StringArray const& texts);
+
+    // Returns the sorted ids of the items that contain all trigrams of the query
+    // Queries shorter than a trigram can't use the index, then this returns nullopt and every item is a candidate
+    std::optional<std::vector<int>> findCandidates(String const& query) const;
+
+    static bool isCandidate(std::vector<int> const& candidates, int id)
+    {
+        return std::binary_search(candidates.begin(), candidates.end(), id);
+    }
+
+private:
+    using Trigram = uint32;
+
+    // Sorted and without duplicates
+    static std::vector<Trigram> getTrigrams(StringArray const& texts);
+
+    std::unordered_map<Trigram, std::vector<int>> postings; // Sorted by id
+};
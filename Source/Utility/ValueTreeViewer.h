@@ -30,6 +30,8 @@ public:
             nodeBranchLine->setTooltip(tooltipPrepend + " " + valueTreeNode.getProperty("Name").toString());
         }
 
+        isOpenedBySearch = valueTreeNode.getProperty("OpenedBySearch");
+
         // Create subcomponents for each child node
         for (int i = 0; i < valueTreeNode.getNumChildren(); ++i)
         {
@@ -40,6 +42,8 @@ public:
 
     void update()
     {
+        isOpenedBySearch = valueTreeNode.getProperty("OpenedBySearch");
+
         // Compare existing child nodes with current children
         for (int i = 0; i < valueTreeNode.getNumChildren(); ++i)
         {
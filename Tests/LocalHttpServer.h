@@ -0,0 +1,98 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Minimal HTTP server on localhost, stands in for a web server so downloads can be tested offline
+// Serves the same body for every GET request, and answers conditional requests with 304 when the ETag matches
+class LocalHttpServer : public juce::Thread {
+public:
+    LocalHttpServer()
+        : juce::Thread("Local HTTP server")
+    {
+        listener.createListener(0, "127.0.0.1");
+        startThread();
+    }
+
+    ~LocalHttpServer() override
+    {
+        signalThreadShouldExit();
+        listener.close();
+        stopThread(2000);
+    }
+
+    juce::URL getURL(juce::String const& path) const
+    {
+        return juce::URL("http://127.0.0.1:" + juce::String(listener.getBoundPort()) + path);
+    }
+
+    void setResponse(juce::MemoryBlock const& newBody, juce::String const& newEtag)
+    {
+        juce::ScopedLock lock(responseLock);
+        body = newBody;
+        etag = newEtag;
+    }
+
+    int getNumRequests() const { return numRequests; }
+    int getNumNotModified() const { return numNotModified; }
+
+    void run() override
+    {
+        while (!threadShouldExit()) {
+            std::unique_ptr<juce::StreamingSocket> client(listener.waitForNextConnection());
+            if (client)
+                handleRequest(*client);
+        }
+    }
+
+private:
+    void handleRequest(juce::StreamingSocket& client)
+    {
+        // Read until the end of the request headers
+        juce::MemoryOutputStream request;
+        char buffer[1024];
+        while (!request.toString().contains("\r\n\r\n") && client.waitUntilReady(true, 2000) == 1) {
+            auto numRead = client.read(buffer, sizeof(buffer), false);
+            if (numRead <= 0)
+                break;
+            request.write(buffer, static_cast<size_t>(numRead));
+        }
+
+        juce::String ifNoneMatch;
+        for (auto const& line : juce::StringArray::fromLines(request.toString())) {
+            if (line.startsWithIgnoreCase("If-None-Match:"))
+                ifNoneMatch = line.fromFirstOccurrenceOf(":", false, false).trim();
+        }
+
+        juce::MemoryBlock responseBody;
+        juce::String responseEtag;
+        {
+            juce::ScopedLock lock(responseLock);
+            responseBody = body;
+            responseEtag = etag;
+        }
+
+        numRequests++;
+
+        juce::MemoryOutputStream response;
+        if (ifNoneMatch.isNotEmpty() && ifNoneMatch == responseEtag) {
+            numNotModified++;
+            response << "HTTP/1.1 304 Not Modified\r\nETag: " << responseEtag << "\r\nConnection: close\r\n\r\n";
+        } else {
+            response << "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: " << juce::String(static_cast<juce::int64>(responseBody.getSize()))
+                     << "\r\nETag: " << responseEtag << "\r\nConnection: close\r\n\r\n";
+            response.write(responseBody.getData(), responseBody.getSize());
+        }
+
+        client.write(response.getData(), static_cast<int>(response.getDataSize()));
+        client.close();
+    }
+
+    juce::StreamingSocket listener;
+
+    juce::CriticalSection responseLock;
+    juce::MemoryBlock body;
+    juce::String etag;
+
+    std::atomic<int> numRequests = 0;
+    std::atomic<int> numNotModified = 0;
+};
@@ -1,15 +1,26 @@
 #include <catch2/catch_all.hpp>
+#include <thread>
 
 // Workaround for naming issue on windows
 #include <juce_graphics/juce_graphics.h>
 #define Rectangle juce::Rectangle
 
 #include <PluginProcessor.h>
+#include <Pd/DocumentationIndex.h>
+#include <Utility/FileSystemWatcher.h>
+#include <Utility/DekenCatalog.h>
+#include <Utility/ThumbnailCache.h>
+#include <Utility/MinMaxPyramid.h>
+#include "LocalHttpServer.h"
 
 
 #include <juce_core/system/juce_TargetPlatform.h>
 #include <Standalone/PlugDataApp.cpp>
 
+#if JUCE_MAC
+#include <mach/mach.h>
+#endif
+
 #if JUCE_MAC
 extern void stopLoop();
 #endif
@@ -77,3 +88,488 @@ TEST_CASE("Create and delete objects", "[name]")
     
     StopApplicationAfter(1500);
 }
+
+TEST_CASE("Documentation search", "[documentation][!benchmark]")
+{
+    auto* index = pd::DocumentationIndex::getInstance();
+
+    auto results = index->search("cosine oscillator");
+    REQUIRE(!results.empty());
+    CHECK(std::any_of(results.begin(), results.end(), [](auto const& result) { return result.name == "osc~"; }));
+
+    // An exact name match should always rank first
+    CHECK(index->search("osc~").front().name == "osc~");
+
+    BENCHMARK("Single term")
+    {
+        return index->search("filter");
+    };
+
+    BENCHMARK("Prefix term")
+    {
+        return index->search("f");
+    };
+
+    BENCHMARK("Multiple terms")
+    {
+        return index->search("low pass filter cutoff frequency");
+    };
+
+    BENCHMARK("Object info lookup")
+    {
+        return index->getObjectInfo("vline~");
+    };
+}
+
+// Resident memory of this process in bytes, or 0 if we can't measure it on this platform
+static size_t getResidentMemory()
+{
+#if JUCE_LINUX || JUCE_BSD
+    auto statm = StringArray::fromTokens(File("/proc/self/statm").loadFileAsString(), true);
+    return static_cast<size_t>(statm[1].getLargeIntValue()) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#elif JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+TEST_CASE("Memory per additional instance", "[memory]")
+{
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    // The first instance pays for everything that's shared
+    std::vector<std::unique_ptr<PluginProcessor>> instances;
+    instances.push_back(std::make_unique<PluginProcessor>());
+
+    auto const numAdditionalInstances = 8;
+    auto memoryBefore = getResidentMemory();
+
+    for (int i = 0; i < numAdditionalInstances; i++) {
+        instances.push_back(std::make_unique<PluginProcessor>());
+    }
+
+    auto memoryAfter = getResidentMemory();
+
+    if (memoryBefore == 0) {
+        WARN("Resident memory can't be measured on this platform");
+        return;
+    }
+
+    auto bytesPerInstance = (static_cast<int64>(memoryAfter) - static_cast<int64>(memoryBefore)) / numAdditionalInstances;
+    WARN("Memory per additional instance: " << bytesPerInstance / 1024 << " KiB");
+
+    // Documentation, abstraction lists, fonts and the look and feel should not be duplicated per instance
+    CHECK(bytesPerInstance < 48 * 1024 * 1024);
+
+    instances.clear();
+}
+
+TEST_CASE("Output is muted during state loads without stalling the audio thread", "[state]")
+{
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    PluginProcessor processor;
+
+    auto const sampleRate = 44100.0;
+    auto const blockSize = 256;
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    // A patch that takes a while to instantiate
+    String patchText = "#N canvas 0 0 800 600 12;\n";
+    for (int i = 0; i < 2000; i++) {
+        patchText += "#X obj 10 " + String(i) + " osc~ " + String(100 + i) + ";\n";
+    }
+
+    processor.loadPatch(patchText, nullptr, 0);
+
+    MemoryBlock state;
+    processor.getStateInformation(state);
+
+    std::atomic<bool> stop = false;
+    std::atomic<double> longestStall = 0.0;
+
+    std::thread audioThread([&]() {
+        AudioBuffer<float> buffer(std::max(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), blockSize);
+        MidiBuffer midi;
+
+        while (!stop) {
+            buffer.clear();
+            midi.clear();
+
+            auto start = Time::getMillisecondCounterHiRes();
+            processor.processBlock(buffer, midi);
+            auto duration = Time::getMillisecondCounterHiRes() - start;
+
+            if (duration > longestStall)
+                longestStall = duration;
+
+            Thread::sleep(static_cast<int>(1000.0 * blockSize / sampleRate / 2.0));
+        }
+    });
+
+    // Let the audio thread get going before we start loading
+    Thread::sleep(100);
+
+    auto loadStart = Time::getMillisecondCounterHiRes();
+    for (int i = 0; i < 3; i++) {
+        processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+    }
+    auto loadTime = (Time::getMillisecondCounterHiRes() - loadStart) / 3.0;
+
+    // Process a few blocks with the new patches in place
+    Thread::sleep(100);
+
+    stop = true;
+    audioThread.join();
+
+    WARN("State load: " << loadTime << " ms, longest audio thread stall: " << longestStall.load() << " ms");
+
+    // The audio thread should never have to wait for the patches to be instantiated
+    CHECK(longestStall.load() < 50.0);
+
+    processor.releaseResources();
+}
+
+TEST_CASE("File system watcher event storm", "[filesystem]")
+{
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    struct CountingListener : public FileSystemWatcher::Listener {
+        void fileChanged(File const file, FileSystemWatcher::FileSystemEvent event) override
+        {
+            numEvents++;
+            if (file.getParentDirectory().getFileName() == "nested")
+                numNestedEvents++;
+
+            FileSystemWatcher::Listener::fileChanged(file, event);
+        }
+
+        bool isInterestedIn(File const& file) override
+        {
+            return file.hasFileExtension("pd");
+        }
+
+        void filesystemChanged() override
+        {
+            numUpdates++;
+        }
+
+        int numEvents = 0;
+        int numNestedEvents = 0;
+        int numUpdates = 0;
+    };
+
+    auto directory = File::createTempFile("watcher_storm");
+    directory.createDirectory();
+
+    {
+        FileSystemWatcher watcher;
+        CountingListener listener;
+        listener.setDebounceTime(200, 1000);
+
+        watcher.addFolder(directory);
+        watcher.addListener(&listener);
+
+        // A watcher that only cares about the top level
+        FileSystemWatcher shallowWatcher;
+        CountingListener shallowListener;
+        shallowWatcher.addFolder(directory, false);
+        shallowWatcher.addListener(&shallowListener);
+
+        // Let the watches settle before we start
+        MessageManager::getInstance()->runDispatchLoopUntil(100);
+
+        // Save a bunch of patches like an editor would: write a temporary file, then rename it over the patch
+        auto nested = directory.getChildFile("nested");
+        nested.createDirectory();
+
+        for (int i = 0; i < 500; i++) {
+            auto patch = (i % 2 ? nested : directory).getChildFile("patch" + String(i % 20) + ".pd");
+            auto temp = patch.withFileExtension(".tmp");
+            temp.replaceWithText("#N canvas 0 0 100 100 12;");
+            temp.moveFileTo(patch);
+        }
+
+        // A change to a file the listener isn't interested in shouldn't reach filesystemChanged
+        MessageManager::getInstance()->runDispatchLoopUntil(500);
+        auto numUpdatesAfterStorm = listener.numUpdates;
+
+        directory.getChildFile("notes.txt").replaceWithText("text");
+        MessageManager::getInstance()->runDispatchLoopUntil(500);
+
+        WARN("Event storm: " << listener.numEvents << " events, " << numUpdatesAfterStorm << " updates");
+
+        // Changes in subfolders are reported too, but only to recursive watchers
+        CHECK(listener.numNestedEvents > 0);
+        CHECK(shallowListener.numEvents > 0);
+        CHECK(shallowListener.numNestedEvents == 0);
+
+        // The storm is coalesced into a handful of updates, instead of one per event
+        CHECK(numUpdatesAfterStorm >= 1);
+        CHECK(numUpdatesAfterStorm <= 3);
+        CHECK(listener.numUpdates == numUpdatesAfterStorm);
+
+        watcher.removeListener(&listener);
+        shallowWatcher.removeListener(&shallowListener);
+    }
+
+    directory.deleteRecursively();
+}
+
+static MemoryBlock createDekenListing(std::vector<std::tuple<String, String, StringArray>> const& versions)
+{
+    ValueTree listing("Packages");
+    for (auto const& [name, version, objects] : versions) {
+        auto package = listing.getChildWithProperty("Name", name);
+        if (!package.isValid()) {
+            package = ValueTree("Package");
+            package.setProperty("Name", name, nullptr);
+            listing.appendChild(package, nullptr);
+        }
+
+        ValueTree versionTree("Version");
+        versionTree.setProperty("Version", version, nullptr);
+        versionTree.setProperty("Author", "author", nullptr);
+        versionTree.setProperty("Description", name + " description", nullptr);
+        versionTree.setProperty("Timestamp", "2023-01-01", nullptr);
+        versionTree.setProperty("URL", "https://example.com/" + name + "-" + version + ".dek", nullptr);
+
+        ValueTree objectsTree("Objects");
+        for (auto const& object : objects) {
+            ValueTree objectTree("Object");
+            objectTree.setProperty("Name", object, nullptr);
+            objectsTree.appendChild(objectTree, nullptr);
+        }
+        versionTree.appendChild(objectsTree, nullptr);
+        package.appendChild(versionTree, nullptr);
+    }
+
+    MemoryOutputStream output;
+    listing.writeToStream(output);
+    return output.getMemoryBlock();
+}
+
+TEST_CASE("Deken catalog search and versions", "[deken]")
+{
+    auto listing = createDekenListing({ { "zexy", "2.4.1", { "abs~", "z~" } },
+        { "zexy", "2.4.3", { "abs~", "z~", "limiter~" } },
+        { "zexy", "2.4.3-rc1", { "abs~" } },
+        { "iemlib", "1.22", { "lp1_t~", "hml_shelf~" } },
+        { "cyclone", "0.9", { "zl", "limi" } } });
+
+    DekenCatalog catalog(listing);
+
+    // Releases come after their pre-releases
+    CHECK(DekenCatalog::compareVersions("2.4.3", "2.4.3-rc1") > 0);
+    CHECK(DekenCatalog::compareVersions("2.4.3-rc1", "2.4.1") > 0);
+    CHECK(DekenCatalog::compareVersions("v0.54.1", "0.54") > 0);
+    CHECK(DekenCatalog::compareVersions("1.10", "1.9") > 0);
+    CHECK(DekenCatalog::compareVersions("1.0", "1.0") == 0);
+
+    // Every package is listed once, with its newest version
+    auto packages = catalog.getPackages();
+    REQUIRE(packages.size() == 3);
+    CHECK(packages[0].version == "2.4.3");
+
+    // Exact object names rank above partial object names
+    auto results = catalog.search("limi");
+    REQUIRE(results.size() == 2);
+    CHECK(results[0].name == "cyclone");
+    CHECK(results[1].name == "zexy");
+
+    CHECK(catalog.search("hml_shelf~")[0].name == "iemlib");
+    CHECK(catalog.search("nothing like this").isEmpty());
+    CHECK(catalog.search("z").size() == 2);
+}
+
+TEST_CASE("Deken catalog revalidation", "[deken]")
+{
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    LocalHttpServer server;
+    auto url = server.getURL("/Linux-amd64-32.bin");
+    auto cacheFile = File::createTempFile("deken_catalog");
+
+    auto firstListing = createDekenListing({ { "zexy", "2.4.3", { "abs~" } } });
+    server.setResponse(firstListing, "\"first\"");
+
+    std::unique_ptr<WebInputStream> stream;
+    MemoryBlock data;
+
+    // Nothing is cached yet, so the listing is downloaded and cached
+    REQUIRE(DekenCatalog::fetch(url, cacheFile, data, stream).wasOk());
+    CHECK(data == firstListing);
+    CHECK(cacheFile.existsAsFile());
+    CHECK(server.getNumNotModified() == 0);
+
+    // The second time, the server only has to confirm that our copy is up to date
+    data.reset();
+    REQUIRE(DekenCatalog::fetch(url, cacheFile, data, stream).wasOk());
+    CHECK(data == firstListing);
+    CHECK(server.getNumNotModified() == 1);
+
+    // A changed listing is downloaded again
+    auto secondListing = createDekenListing({ { "zexy", "2.4.3", { "abs~" } }, { "iemlib", "1.22", { "hml_shelf~" } } });
+    server.setResponse(secondListing, "\"second\"");
+
+    REQUIRE(DekenCatalog::fetch(url, cacheFile, data, stream).wasOk());
+    CHECK(data == secondListing);
+    CHECK(DekenCatalog(data).getPackages().size() == 2);
+    CHECK(server.getNumRequests() == 3);
+
+    // Without a server, the cached copy is used
+    auto offlineUrl = URL("http://127.0.0.1:1/Linux-amd64-32.bin");
+    data.reset();
+    REQUIRE(DekenCatalog::fetch(offlineUrl, cacheFile, data, stream).wasOk());
+    CHECK(data == secondListing);
+
+    cacheFile.deleteFile();
+    CHECK(DekenCatalog::fetch(offlineUrl, cacheFile, data, stream).failed());
+}
+
+TEST_CASE("Thumbnail cache", "[thumbnails]")
+{
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    // A wide image, so it has to be cropped to fit the thumbnail
+    Image artwork(Image::RGB, 400, 100, true);
+    {
+        Graphics g(artwork);
+        g.fillAll(Colours::red);
+        g.setColour(Colours::blue);
+        g.fillRect(150, 0, 100, 100);
+    }
+
+    MemoryOutputStream encoded;
+    PNGImageFormat().writeImageToStream(artwork, encoded);
+
+    LocalHttpServer server;
+    server.setResponse(encoded.getMemoryBlock(), "\"artwork\"");
+
+    auto directory = File::createTempFile("thumbnails");
+
+    auto waitForThumbnails = [](ThumbnailCache& cache, std::vector<URL> const& urls) {
+        std::vector<Image> results(urls.size());
+        int numFinished = 0;
+        for (size_t i = 0; i < urls.size(); i++) {
+            cache.requestThumbnail(urls[i], 50, 50, [&results, &numFinished, i](Image image) {
+                results[i] = image;
+                numFinished++;
+            });
+        }
+
+        auto start = Time::getMillisecondCounter();
+        while (numFinished < static_cast<int>(urls.size()) && Time::getMillisecondCounter() - start < 10000) {
+            MessageManager::getInstance()->runDispatchLoopUntil(10);
+        }
+
+        return results;
+    };
+
+    auto url = server.getURL("/artwork.png");
+
+    {
+        ThumbnailCache cache(directory, 1024 * 1024, 1024 * 1024, 4);
+
+        // Asking for the same thumbnail many times at once only downloads it once
+        auto results = waitForThumbnails(cache, std::vector<URL>(8, url));
+        CHECK(server.getNumRequests() == 1);
+
+        for (auto const& image : results) {
+            REQUIRE(image.isValid());
+            CHECK(image.getWidth() == 50);
+            CHECK(image.getHeight() == 50);
+        }
+
+        // The centre of the image was kept
+        CHECK(results[0].getPixelAt(25, 25).getBlue() > 200);
+
+        // After that, it comes from memory
+        CHECK(cache.getCachedThumbnail(url, 50, 50).isValid());
+        CHECK_FALSE(cache.getCachedThumbnail(url, 60, 60).isValid());
+    }
+
+    {
+        // A new cache finds it on disk
+        ThumbnailCache cache(directory, 1024 * 1024, 1024 * 1024, 4);
+        CHECK_FALSE(cache.getCachedThumbnail(url, 50, 50).isValid());
+
+        auto results = waitForThumbnails(cache, { url });
+        CHECK(results[0].isValid());
+        CHECK(server.getNumRequests() == 1);
+    }
+
+    {
+        // Memory and disk stay within budget, only a few 50x50 thumbnails fit in 30 kB
+        ThumbnailCache cache(directory, 30 * 1024, 1024, 4);
+
+        std::vector<URL> urls;
+        for (int i = 0; i < 20; i++) {
+            urls.push_back(server.getURL("/artwork.png?id=" + String(i)));
+        }
+
+        auto results = waitForThumbnails(cache, urls);
+        CHECK(std::all_of(results.begin(), results.end(), [](Image const& image) { return image.isValid(); }));
+
+        auto numInMemory = std::count_if(urls.begin(), urls.end(), [&cache](URL const& url) { return cache.getCachedThumbnail(url, 50, 50).isValid(); });
+        CHECK(numInMemory >= 1);
+        CHECK(numInMemory <= 3);
+
+        int64 diskSize = 0;
+        for (auto const& file : directory.findChildFiles(File::findFiles, false, "*.png")) {
+            diskSize += file.getSize();
+        }
+        CHECK(directory.getNumberOfChildFiles(File::findFiles, "*.png") >= 1);
+        CHECK(diskSize <= 1024);
+    }
+
+    directory.deleteRecursively();
+}
+
+TEST_CASE("Min/max pyramid", "[arrays]")
+{
+    Random random(42);
+    std::vector<float> samples(10000);
+    for (auto& sample : samples) {
+        sample = random.nextFloat() * 2.0f - 1.0f;
+    }
+
+    // A single peak inside a block that a pixel only partly covers
+    samples[4003] = 10.0f;
+
+    MinMaxPyramid pyramid;
+    pyramid.build(samples.data(), static_cast<int>(samples.size()));
+
+    auto checkExact = [&samples, &pyramid](int numPixels) {
+        std::vector<Range<float>> ranges;
+        pyramid.getMinMax(samples.data(), numPixels, ranges);
+        REQUIRE(ranges.size() == static_cast<size_t>(numPixels));
+
+        int numWrong = 0;
+        auto const numSamples = static_cast<int>(samples.size());
+        for (int px = 0; px < numPixels; px++) {
+            auto const start = static_cast<int>(static_cast<int64>(px) * numSamples / numPixels);
+            auto const end = std::max(start + 1, static_cast<int>(static_cast<int64>(px + 1) * numSamples / numPixels));
+            if (ranges[px] != FloatVectorOperations::findMinAndMax(samples.data() + start, end - start))
+                numWrong++;
+        }
+        CHECK(numWrong == 0);
+    };
+
+    // Every pixel gets the range of exactly its own samples, not of the whole blocks it touches
+    checkExact(7);
+    checkExact(123);
+    checkExact(300);
+    checkExact(4999);
+
+    // Only the changed blocks are updated
+    std::fill(samples.begin() + 2500, samples.begin() + 2600, -5.0f);
+    pyramid.update(samples.data(), static_cast<int>(samples.size()), 2500, 2600);
+    checkExact(123);
+    checkExact(300);
+}